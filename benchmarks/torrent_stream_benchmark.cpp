@@ -0,0 +1,561 @@
+/**
+ * @file torrent_stream_benchmark.cpp
+ * @brief Offline local-swarm benchmark for TorrentStreamServer
+ *
+ * Creates a sparse synthetic payload, seeds it from libtorrent sessions bound
+ * to loopback addresses and streams it through TorrentStreamServer with
+ * scripted HTTP Range patterns. Every (profile, pattern) run starts from an
+ * empty cache, so the first request includes the metadata exchange just like
+ * a fresh magnet in the app.
+ *
+ * Patterns:
+ *   linear - one contiguous read from the start of the file
+ *   seek   - reads at seeded random offsets, like a viewer scrubbing
+ *   probe  - MP4-style container probe: head, tail (suffix range), then play
+ *
+ * Reported per run: client time to first byte (first request and median),
+ * sustained MB/s, reader stalls from the server stats and process peak RSS.
+ * The peak is reset before every run; where the kernel cannot reset it the value
+ * is marked with '*' and includes earlier runs.
+ * The process exits non-zero if any request fails or times out, so it can run
+ * as a CI step:
+ *
+ *   torrent_stream_benchmark --size-mb 4096 --profiles streaming,low-resource
+ *
+ * Seeders listen on 127.0.0.1, 127.0.0.2, ...; the streaming session only
+ * accepts one connection per IP, so more than one seeder needs the whole
+ * 127.0.0.0/8 block routed to loopback (the default on Linux).
+ */
+
+#include "core/services/torrent_stream_server.h"
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QNetworkAccessManager>
+#include <QNetworkProxy>
+#include <QNetworkReply>
+#include <QNetworkRequest>
+#include <QRandomGenerator>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <QThread>
+#include <QTimer>
+#include <QUrl>
+
+#include <libtorrent/add_torrent_params.hpp>
+#include <libtorrent/bencode.hpp>
+#include <libtorrent/create_torrent.hpp>
+#include <libtorrent/magnet_uri.hpp>
+#include <libtorrent/session.hpp>
+#include <libtorrent/settings_pack.hpp>
+#include <libtorrent/torrent_flags.hpp>
+#include <libtorrent/torrent_info.hpp>
+
+#include <algorithm>
+#include <iterator>
+#include <memory>
+#include <vector>
+
+namespace {
+
+constexpr qint64 kMiB = 1024 * 1024;
+constexpr qint64 kStallThresholdMs = 100; // same threshold as the server's stall counter
+
+struct RangeRequest {
+    qint64 start = 0;
+    qint64 end = -1;          // inclusive, -1 = suffix request
+    qint64 suffixLength = 0;  // used when end == -1
+};
+
+struct RequestResult {
+    bool ok = false;
+    QString error;
+    qint64 firstByteMs = -1;
+    qint64 totalMs = 0;
+    qint64 bytes = 0;
+    qint64 stalls = 0;
+    qint64 maxGapMs = 0;
+};
+
+struct RunResult {
+    QString profile;
+    QString pattern;
+    bool ok = true;
+    QString error;
+    qint64 requests = 0;
+    qint64 firstRequestTtfbMs = -1;
+    qint64 medianTtfbMs = -1;
+    qint64 bytes = 0;
+    qint64 transferMs = 0;
+    qint64 clientStalls = 0;
+    qint64 maxGapMs = 0;
+    QVariantMap serverStats;
+    qint64 peakRssKb = -1;
+    bool peakRssReset = false; // peakRssKb covers this run only
+
+    double sustainedMBps() const
+    {
+        return transferMs > 0 ? (bytes / double(kMiB)) / (transferMs / 1000.0) : 0.0;
+    }
+};
+
+/**
+ * @brief Peak resident set size of this process in KiB, -1 where unsupported
+ *
+ * Seeders run in the same process, so this is an upper bound for the
+ * streaming side alone. It is a high-water mark: see resetPeakRss().
+ */
+qint64 peakRssKb()
+{
+#ifdef Q_OS_LINUX
+    QFile status("/proc/self/status");
+    if (!status.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        return -1;
+    }
+    const QList<QByteArray> lines = status.readAll().split('\n');
+    for (const QByteArray& line : lines) {
+        if (line.startsWith("VmHWM:")) {
+            return line.mid(6).trimmed().split(' ').value(0).toLongLong();
+        }
+    }
+#endif
+    return -1;
+}
+
+/**
+ * @brief Restart the peak RSS from the current RSS, so each run reports its own peak
+ * @return False where the kernel cannot reset it; peakRssKb() is then cumulative
+ */
+bool resetPeakRss()
+{
+#ifdef Q_OS_LINUX
+    // "5" resets VmHWM (Linux 4.0+)
+    QFile clearRefs("/proc/self/clear_refs");
+    return clearRefs.open(QIODevice::WriteOnly) && clearRefs.write("5") == 1;
+#else
+    return false;
+#endif
+}
+
+/**
+ * @brief Fetch one byte range, recording time to first byte and read gaps
+ */
+RequestResult fetchRange(QNetworkAccessManager& manager, const QUrl& url,
+                         const RangeRequest& range, int timeoutMs)
+{
+    RequestResult result;
+    QNetworkRequest request(url);
+    QByteArray rangeHeader = range.end < 0
+        ? QByteArray("bytes=-") + QByteArray::number(range.suffixLength)
+        : QByteArray("bytes=") + QByteArray::number(range.start) + '-' + QByteArray::number(range.end);
+    request.setRawHeader("Range", rangeHeader);
+
+    QElapsedTimer timer;
+    QElapsedTimer sinceLastRead;
+    timer.start();
+    QNetworkReply* reply = manager.get(request);
+
+    QEventLoop loop;
+    QTimer timeout;
+    timeout.setSingleShot(true);
+    bool timedOut = false;
+    QObject::connect(&timeout, &QTimer::timeout, &loop, [&]() {
+        timedOut = true;
+        reply->abort();
+    });
+    QObject::connect(reply, &QNetworkReply::readyRead, &loop, [&]() {
+        QByteArray chunk = reply->readAll();
+        if (chunk.isEmpty()) {
+            return;
+        }
+        if (result.firstByteMs < 0) {
+            result.firstByteMs = timer.elapsed();
+        } else {
+            qint64 gap = sinceLastRead.elapsed();
+            result.maxGapMs = qMax(result.maxGapMs, gap);
+            if (gap >= kStallThresholdMs) {
+                ++result.stalls;
+            }
+        }
+        sinceLastRead.start();
+        result.bytes += chunk.size();
+    });
+    QObject::connect(reply, &QNetworkReply::finished, &loop, &QEventLoop::quit);
+    timeout.start(timeoutMs);
+    loop.exec();
+
+    result.totalMs = timer.elapsed();
+    int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    if (timedOut) {
+        result.error = QString("timed out after %1 ms (%2 bytes)").arg(timeoutMs).arg(result.bytes);
+    } else if (reply->error() != QNetworkReply::NoError) {
+        result.error = reply->errorString();
+    } else if (status != 206) {
+        result.error = QString("expected 206, got %1").arg(status);
+    } else {
+        qint64 expected = range.end < 0 ? range.suffixLength : range.end - range.start + 1;
+        if (result.bytes != expected) {
+            result.error = QString("expected %1 bytes, got %2").arg(expected).arg(result.bytes);
+        } else {
+            result.ok = true;
+        }
+    }
+    reply->deleteLater();
+    return result;
+}
+
+/**
+ * @brief Range requests a player issues for one access pattern
+ */
+QList<RangeRequest> patternRequests(const QString& pattern, qint64 fileSize,
+                                    qint64 readBytes, int seeks, quint32 seed)
+{
+    QList<RangeRequest> requests;
+    readBytes = qMin(readBytes, fileSize);
+    if (pattern == "linear") {
+        requests.append({0, readBytes - 1, 0});
+    } else if (pattern == "seek") {
+        // Fixed seed: every profile sees the same offsets
+        QRandomGenerator random(seed);
+        qint64 chunk = qMax<qint64>(kMiB, readBytes / qMax(1, seeks));
+        chunk = qMin(chunk, fileSize);
+        for (int i = 0; i < seeks; ++i) {
+            qint64 start = random.bounded(fileSize - chunk + 1);
+            requests.append({start, start + chunk - 1, 0});
+        }
+    } else if (pattern == "probe") {
+        // Demuxers read the head, jump to the tail for the index, then play
+        qint64 head = qMin<qint64>(64 * 1024, fileSize);
+        requests.append({0, head - 1, 0});
+        requests.append({0, -1, qMin(kMiB, fileSize)});
+        if (head < readBytes) {
+            requests.append({head, readBytes - 1, 0});
+        }
+    }
+    return requests;
+}
+
+/**
+ * @brief libtorrent sessions seeding the payload from loopback addresses
+ */
+class LocalSwarm
+{
+public:
+    bool start(const std::shared_ptr<const libtorrent::torrent_info>& ti, const QString& savePath,
+               int seederCount, QString& error)
+    {
+        for (int i = 0; i < seederCount; ++i) {
+            QString address = QString("127.0.0.%1").arg(i + 1);
+            libtorrent::settings_pack settings;
+            using sp = libtorrent::settings_pack;
+            settings.set_str(sp::listen_interfaces, QString("%1:0").arg(address).toStdString());
+            settings.set_str(sp::outgoing_interfaces, address.toStdString());
+            settings.set_bool(sp::enable_dht, false);
+            settings.set_bool(sp::enable_lsd, false);
+            settings.set_bool(sp::enable_upnp, false);
+            settings.set_bool(sp::enable_natpmp, false);
+            settings.set_int(sp::alert_mask, 0);
+            settings.set_int(sp::upload_rate_limit, 0);
+            auto session = std::make_unique<libtorrent::session>(settings);
+
+            libtorrent::add_torrent_params params;
+            params.ti = std::make_shared<libtorrent::torrent_info>(*ti);
+            params.save_path = savePath.toStdString();
+            // The payload is known to be complete: skip the full recheck
+            params.flags |= libtorrent::torrent_flags::seed_mode;
+            libtorrent::error_code ec;
+            session->add_torrent(params, ec);
+            if (ec) {
+                error = QString("seeder %1: %2").arg(address, QString::fromStdString(ec.message()));
+                return false;
+            }
+
+            // Listen sockets are opened asynchronously
+            QElapsedTimer wait;
+            wait.start();
+            while (session->listen_port() == 0 && wait.elapsed() < 5000) {
+                QThread::msleep(10);
+            }
+            if (session->listen_port() == 0) {
+                error = QString("seeder %1 did not start listening").arg(address);
+                return false;
+            }
+            m_peers.append(QString("%1:%2").arg(address).arg(session->listen_port()));
+            m_sessions.push_back(std::move(session));
+        }
+        return true;
+    }
+
+    QStringList peers() const { return m_peers; }
+
+private:
+    std::vector<std::unique_ptr<libtorrent::session>> m_sessions;
+    QStringList m_peers;
+};
+
+/**
+ * @brief Create a sparse payload and a torrent for it
+ */
+std::shared_ptr<const libtorrent::torrent_info> createPayload(const QString& payloadDir,
+                                                              const QString& fileName,
+                                                              qint64 size, QString& error)
+{
+    QDir().mkpath(payloadDir);
+    QFile payload(QDir(payloadDir).absoluteFilePath(fileName));
+    // Sparse: takes no disk space and hashes at memory speed
+    if (!payload.open(QIODevice::WriteOnly) || !payload.resize(size)) {
+        error = QString("cannot create payload: %1").arg(payload.errorString());
+        return nullptr;
+    }
+    payload.close();
+
+    libtorrent::file_storage files;
+    libtorrent::add_files(files, payload.fileName().toStdString());
+    libtorrent::create_torrent creator(files);
+    creator.set_creator("yantrium torrent_stream_benchmark");
+    libtorrent::error_code ec;
+    libtorrent::set_piece_hashes(creator, payloadDir.toStdString(), ec);
+    if (ec) {
+        error = QString("hashing payload failed: %1").arg(QString::fromStdString(ec.message()));
+        return nullptr;
+    }
+
+    std::vector<char> buffer;
+    libtorrent::bencode(std::back_inserter(buffer), creator.generate());
+    auto ti = std::make_shared<libtorrent::torrent_info>(buffer, ec, libtorrent::from_span);
+    if (ec) {
+        error = QString("invalid torrent: %1").arg(QString::fromStdString(ec.message()));
+        return nullptr;
+    }
+    return ti;
+}
+
+qint64 median(QList<qint64> values)
+{
+    if (values.isEmpty()) {
+        return -1;
+    }
+    std::sort(values.begin(), values.end());
+    return values.at(values.size() / 2);
+}
+
+/**
+ * @brief Stream one pattern under one profile from a cold cache
+ */
+RunResult runPattern(const QString& profile, const QString& pattern, const QString& magnet,
+                     const QString& cacheRoot, qint64 fileSize, qint64 readBytes, int seeks,
+                     quint32 seed, int timeoutMs)
+{
+    RunResult run;
+    run.profile = profile;
+    run.pattern = pattern;
+    run.peakRssReset = resetPeakRss();
+
+    QString cacheDir = QDir(cacheRoot).absoluteFilePath(profile + "-" + pattern);
+    {
+        TorrentStreamServer server;
+        server.setCacheSettings(cacheDir, 0);
+        if (!server.setSessionProfile(profile)) {
+            run.ok = false;
+            run.error = "unknown profile";
+            return run;
+        }
+        if (!server.startServer(0)) {
+            run.ok = false;
+            run.error = "stream server did not start";
+            return run;
+        }
+        QString streamUrl = server.addMagnetLink(magnet);
+        if (streamUrl.isEmpty()) {
+            run.ok = false;
+            run.error = "magnet was rejected";
+            return run;
+        }
+
+        QNetworkAccessManager manager;
+        manager.setProxy(QNetworkProxy::NoProxy);
+        QList<qint64> ttfbs;
+        const QList<RangeRequest> requests = patternRequests(pattern, fileSize, readBytes, seeks, seed);
+        for (const RangeRequest& range : requests) {
+            RequestResult result = fetchRange(manager, QUrl(streamUrl), range, timeoutMs);
+            ++run.requests;
+            if (!result.ok) {
+                run.ok = false;
+                run.error = QString("request %1: %2").arg(run.requests).arg(result.error);
+                break;
+            }
+            if (run.firstRequestTtfbMs < 0) {
+                run.firstRequestTtfbMs = result.firstByteMs;
+            }
+            ttfbs.append(result.firstByteMs);
+            run.bytes += result.bytes;
+            run.transferMs += result.totalMs - result.firstByteMs;
+            run.clientStalls += result.stalls;
+            run.maxGapMs = qMax(run.maxGapMs, result.maxGapMs);
+        }
+        run.medianTtfbMs = median(ttfbs);
+        run.serverStats = server.getFirstByteLatencyStats();
+        server.removeTorrent(streamUrl);
+        server.stopServer();
+    }
+    run.peakRssKb = peakRssKb();
+    QDir(cacheDir).removeRecursively();
+    return run;
+}
+
+QJsonObject toJson(const RunResult& run)
+{
+    QJsonObject object;
+    object["profile"] = run.profile;
+    object["pattern"] = run.pattern;
+    object["ok"] = run.ok;
+    if (!run.ok) {
+        object["error"] = run.error;
+    }
+    object["requests"] = run.requests;
+    object["firstRequestTtfbMs"] = run.firstRequestTtfbMs;
+    object["medianTtfbMs"] = run.medianTtfbMs;
+    object["bytes"] = run.bytes;
+    object["sustainedMBps"] = run.sustainedMBps();
+    object["clientStalls"] = run.clientStalls;
+    object["maxGapMs"] = run.maxGapMs;
+    object["server"] = QJsonObject::fromVariantMap(run.serverStats);
+    object["peakRssKb"] = run.peakRssKb;
+    object["peakRssPerRun"] = run.peakRssReset;
+    return object;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("torrent_stream_benchmark");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Streams a synthetic torrent from a local swarm through "
+                                     "TorrentStreamServer and reports TTFB, throughput and stalls.");
+    parser.addHelpOption();
+    QCommandLineOption sizeOption("size-mb", "Payload size in MiB.", "mb", "2048");
+    QCommandLineOption seedersOption("seeders", "Number of loopback seeders.", "count", "2");
+    QCommandLineOption profilesOption("profiles", "Comma-separated session profiles.", "list",
+                                      "streaming,balanced,low-resource");
+    QCommandLineOption patternsOption("patterns", "Comma-separated patterns (linear, seek, probe).",
+                                      "list", "linear,seek,probe");
+    QCommandLineOption readOption("read-mb", "MiB read per pattern.", "mb", "64");
+    QCommandLineOption seeksOption("seeks", "Number of random seeks in the seek pattern.", "count", "8");
+    QCommandLineOption seedOption("seed", "Seed for the seek offsets.", "seed", "1");
+    QCommandLineOption timeoutOption("timeout-s", "Timeout per request in seconds.", "seconds", "120");
+    QCommandLineOption jsonOption("json", "Also write the results as JSON to this file.", "path");
+    QCommandLineOption workOption("work-dir", "Directory for payload and caches (default: temporary).", "path");
+    parser.addOptions({sizeOption, seedersOption, profilesOption, patternsOption, readOption,
+                       seeksOption, seedOption, timeoutOption, jsonOption, workOption});
+    parser.process(app);
+
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+
+    qint64 fileSize = parser.value(sizeOption).toLongLong() * kMiB;
+    int seederCount = parser.value(seedersOption).toInt();
+    qint64 readBytes = parser.value(readOption).toLongLong() * kMiB;
+    int seeks = parser.value(seeksOption).toInt();
+    quint32 seed = parser.value(seedOption).toUInt();
+    int timeoutMs = parser.value(timeoutOption).toInt() * 1000;
+    const QStringList profiles = parser.value(profilesOption).split(',', Qt::SkipEmptyParts);
+    const QStringList patterns = parser.value(patternsOption).split(',', Qt::SkipEmptyParts);
+    if (fileSize <= 0 || seederCount <= 0 || readBytes <= 0 || seeks <= 0 || timeoutMs <= 0) {
+        err << "Sizes, counts and timeouts must be positive" << Qt::endl;
+        return 2;
+    }
+    for (const QString& pattern : patterns) {
+        if (pattern != "linear" && pattern != "seek" && pattern != "probe") {
+            err << "Unknown pattern: " << pattern << Qt::endl;
+            return 2;
+        }
+    }
+
+    QTemporaryDir tempDir;
+    QString workDir = parser.isSet(workOption) ? parser.value(workOption) : tempDir.path();
+    if (workDir.isEmpty()) {
+        err << "Cannot create a working directory" << Qt::endl;
+        return 2;
+    }
+    QString payloadDir = QDir(workDir).absoluteFilePath("payload");
+    QString cacheRoot = QDir(workDir).absoluteFilePath("cache");
+
+    QElapsedTimer setup;
+    setup.start();
+    QString error;
+    auto ti = createPayload(payloadDir, "benchmark.mkv", fileSize, error);
+    if (!ti) {
+        err << error << Qt::endl;
+        return 1;
+    }
+    LocalSwarm swarm;
+    if (!swarm.start(ti, payloadDir, seederCount, error)) {
+        err << error << Qt::endl;
+        return 1;
+    }
+    // Peers are handed to the stream session through the magnet (x.pe), so no
+    // tracker, DHT or LSD is needed to find the swarm
+    QString magnet = QString::fromStdString(libtorrent::make_magnet_uri(*ti));
+    for (const QString& peer : swarm.peers()) {
+        magnet += "&x.pe=" + peer;
+    }
+    out << QString("Payload %1 MiB, %2 pieces of %3 KiB, %4 seeder(s) [%5], setup %6 ms")
+               .arg(fileSize / kMiB).arg(ti->num_pieces()).arg(ti->piece_length() / 1024)
+               .arg(seederCount).arg(swarm.peers().join(", ")).arg(setup.elapsed())
+        << Qt::endl;
+    out << "profile       pattern   ttfb1 ms  ttfb50 ms     MB/s  stalls  stall ms  max gap  rss MiB"
+        << Qt::endl;
+
+    QJsonArray results;
+    bool allOk = true;
+    for (const QString& profile : profiles) {
+        for (const QString& pattern : patterns) {
+            RunResult run = runPattern(profile, pattern, magnet, cacheRoot, fileSize, readBytes,
+                                       seeks, seed, timeoutMs);
+            results.append(toJson(run));
+            if (!run.ok) {
+                allOk = false;
+                out << QString("%1 %2 FAILED: %3").arg(profile, -13).arg(pattern, -8).arg(run.error)
+                    << Qt::endl;
+                continue;
+            }
+            out << QString("%1 %2 %3 %4 %5 %6 %7 %8 %9")
+                       .arg(profile, -13).arg(pattern, -8)
+                       .arg(run.firstRequestTtfbMs, 9).arg(run.medianTtfbMs, 10)
+                       .arg(run.sustainedMBps(), 8, 'f', 1)
+                       .arg(run.serverStats.value("stalls").toLongLong(), 7)
+                       .arg(run.serverStats.value("stallMs").toLongLong(), 9)
+                       .arg(run.maxGapMs, 8)
+                       .arg(run.peakRssKb < 0 ? QString("n/a")
+                                              : QString::number(run.peakRssKb / 1024)
+                                                    + (run.peakRssReset ? "" : "*"), 8)
+                << Qt::endl;
+        }
+    }
+
+    if (parser.isSet(jsonOption)) {
+        QJsonObject report;
+        report["payloadBytes"] = fileSize;
+        report["pieceLength"] = ti->piece_length();
+        report["seeders"] = seederCount;
+        report["readBytes"] = readBytes;
+        report["runs"] = results;
+        QFile json(parser.value(jsonOption));
+        if (!json.open(QIODevice::WriteOnly | QIODevice::Truncate)
+            || json.write(QJsonDocument(report).toJson()) < 0) {
+            err << "Cannot write " << json.fileName() << Qt::endl;
+            return 1;
+        }
+    }
+    return allOk ? 0 : 1;
+}
@@ -17,6 +17,7 @@ Item {
     property bool isHovered: false
     
     signal clicked()
+    signal focused()  // hovered or given keyboard focus; a Play is likely to follow
     
     width: 480  // 20% bigger: 400 * 1.2 = 480
     height: 270  // 20% bigger: 225 * 1.2 = 270 (Landscape aspect ratio)
@@ -24,11 +25,16 @@ Item {
     MouseArea {
         anchors.fill: parent
         hoverEnabled: true
-        onEntered: isHovered = true
+        onEntered: {
+            isHovered = true
+            root.focused()
+        }
         onExited: isHovered = false
         onClicked: root.clicked()
     }
     
+    onActiveFocusChanged: if (activeFocus) root.focused()
+    
     // Rounded backdrop image container
     Item {
         id: imageContainer
@@ -20,6 +20,17 @@ Rectangle {
     
     color: "transparent"
     
+    // Sweeping the mouse across a row focuses every card it crosses; only the
+    // card focus rests on is worth asking every stream addon about
+    Timer {
+        id: prefetchTimer
+        interval: 500
+        property var card: null
+        property var itemData: ({})
+        property string episodeId: ""
+        onTriggered: StreamService.prefetchStreams(itemData, episodeId)
+    }
+    
     Column {
         anchors.fill: parent
         spacing: 12
@@ -119,6 +130,28 @@ Rectangle {
                                     root.itemClicked(contentId, contentType, model.addonId || root.addonId || "")
                                 }
                             })
+                            // Resolve streams in the background (no-op unless prefetch is enabled),
+                            // once focus has settled on the card
+                            item.focused.connect(function() {
+                                var isEpisode = model.type === "episode"
+                                var episodeId = ""
+                                if (isEpisode && model.season > 0 && model.episode > 0) {
+                                    episodeId = "S" + String(model.season).padStart(2, '0') + "E" + String(model.episode).padStart(2, '0')
+                                }
+                                prefetchTimer.card = item
+                                prefetchTimer.itemData = {
+                                    id: model.imdbId || model.id || "",
+                                    imdbId: model.imdbId || "",
+                                    type: isEpisode ? "tv" : (model.type || "")
+                                }
+                                prefetchTimer.episodeId = episodeId
+                                prefetchTimer.restart()
+                            })
+                            item.isHoveredChanged.connect(function() {
+                                if (!item.isHovered && !item.activeFocus && prefetchTimer.card === item) {
+                                    prefetchTimer.stop()
+                                }
+                            })
                         } else {
                             item.posterUrl = Qt.binding(function() { return model.posterUrl || model.poster || "" })
                             item.title = Qt.binding(function() { return model.title || "" })
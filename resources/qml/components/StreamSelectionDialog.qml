@@ -161,6 +161,12 @@ Dialog {
     
     Connections {
         target: streamService
+        function onStreamsBatchLoaded(addonId, streams) {
+            // Show each addon's streams as soon as it answers
+            if (root.isLoading) {
+                root.streams = root.streams.concat(streams)
+            }
+        }
         function onStreamsLoaded(streams) {
             root.streams = streams
             root.isLoading = false
@@ -171,6 +177,9 @@ Dialog {
         }
     }
     
+    // Addons still answering for this item are no longer needed
+    onClosed: streamService.cancelStreams()
+    
     function loadStreams(itemData, episodeId) {
         root.streams = []
         root.isLoading = true
@@ -90,6 +90,15 @@ Item {
         function onSmartPlayStateLoaded(smartPlayState) {
             root.smartPlayState = smartPlayState
             console.log("[DetailScreen] Smart play state loaded:", JSON.stringify(smartPlayState))
+
+            // Resolve what Play will open in the background (no-op unless prefetch is enabled)
+            if (smartPlayState.action !== "soon") {
+                var episodeId = ""
+                if (root.itemData.type === "tv" && smartPlayState.season > 0 && smartPlayState.episode > 0) {
+                    episodeId = "S" + String(smartPlayState.season).padStart(2, '0') + "E" + String(smartPlayState.episode).padStart(2, '0')
+                }
+                StreamService.prefetchStreams(root.itemData, episodeId)
+            }
         }
         function onSeasonEpisodesLoaded(seasonNumber, episodes) {
             if (seasonNumber === root.selectedSeasonNumber) {
@@ -14,6 +14,7 @@ Item {
     property CatalogPreferencesService catalogPrefsService: CatalogPreferencesService
     property LibraryService libraryService: LibraryService
     property Configuration configuration: Configuration
+    property TorrentService torrentService: TorrentService
     
     Rectangle {
         anchors.fill: parent
@@ -649,6 +650,142 @@ Item {
                     }
                 }
                 
+                // ==========================================
+                // STREAMING SECTION
+                // ==========================================
+                Rectangle {
+                    width: parent.width
+                    height: streamingSection.height + 40
+                    color: "#1a1a1a"
+                    radius: 8
+                    visible: torrentService.isAvailable()
+                    
+                    Column {
+                        id: streamingSection
+                        width: parent.width - 40
+                        anchors.left: parent.left
+                        anchors.top: parent.top
+                        anchors.margins: 20
+                        spacing: 20
+                        
+                        // Header
+                        Column {
+                            width: parent.width
+                            spacing: 4
+                            Text {
+                                text: "Streaming"
+                                font.pixelSize: 28
+                                font.bold: true
+                                color: "#ffffff"
+                            }
+                            Text {
+                                text: "Tune how torrent streams use your connection."
+                                font.pixelSize: 14
+                                color: "#aaaaaa"
+                                wrapMode: Text.WordWrap
+                                width: parent.width
+                            }
+                        }
+                        
+                        // Torrent Profile Card
+                        Rectangle {
+                            width: Math.max(350, Math.min(450, (parent.width - 20) / 2))
+                            height: profileCardContent.height + 32
+                            color: "#252525"
+                            radius: 8
+                            border.color: "#2d2d2d"
+                            border.width: 1
+                            
+                            Column {
+                                id: profileCardContent
+                                anchors.left: parent.left
+                                anchors.right: parent.right
+                                anchors.top: parent.top
+                                anchors.margins: 16
+                                spacing: 12
+                                
+                                // Title
+                                Text {
+                                    width: parent.width
+                                    text: "Torrent Profile"
+                                    font.pixelSize: 20
+                                    font.bold: true
+                                    color: "#FFFFFF"
+                                }
+                                
+                                // Description
+                                Text {
+                                    width: parent.width
+                                    text: "Streaming starts playback fastest, Balanced also suits slower connections, Low resource keeps memory and connections down."
+                                    font.pixelSize: 13
+                                    color: "#AAAAAA"
+                                    wrapMode: Text.WordWrap
+                                }
+                                
+                                // Profile choice
+                                Row {
+                                    spacing: 8
+                                    
+                                    Repeater {
+                                        model: [
+                                            { profile: "streaming", label: "Streaming" },
+                                            { profile: "balanced", label: "Balanced" },
+                                            { profile: "low-resource", label: "Low resource" }
+                                        ]
+                                        
+                                        Button {
+                                            required property var modelData
+                                            property bool selected: configuration.torrentSessionProfile === modelData.profile
+                                            width: 120
+                                            height: 36
+                                            text: modelData.label
+                                            background: Rectangle {
+                                                color: parent.selected ? "#ffffff" : (parent.pressed ? "#3d3d3d" : "#2d2d2d")
+                                                radius: 4
+                                            }
+                                            contentItem: Text {
+                                                text: parent.text
+                                                color: parent.selected ? "#000000" : "#ffffff"
+                                                font.bold: true
+                                                font.pixelSize: 13
+                                                horizontalAlignment: Text.AlignHCenter
+                                                verticalAlignment: Text.AlignVCenter
+                                            }
+                                            onClicked: {
+                                                if (!selected && configuration.saveTorrentSessionProfile(modelData.profile)) {
+                                                    profileStatsText.refresh()
+                                                }
+                                            }
+                                        }
+                                    }
+                                }
+                                
+                                // Measured with the current profile, so profiles can be compared
+                                Text {
+                                    id: profileStatsText
+                                    width: parent.width
+                                    font.pixelSize: 12
+                                    color: "#aaaaaa"
+                                    wrapMode: Text.WordWrap
+                                    
+                                    function refresh() {
+                                        let stats = torrentService.getFirstByteLatencyStats()
+                                        if (!stats.count) {
+                                            text = "No streams played with this profile yet"
+                                            return
+                                        }
+                                        text = "Time to first byte: " + stats.p50Ms + " ms median, " + stats.p95Ms + " ms p95 over "
+                                               + stats.count + " request(s). Stalls: " + stats.stalls
+                                               + ". Throughput: " + (stats.sustainedBytesPerSecond / (1024 * 1024)).toFixed(1) + " MB/s"
+                                    }
+                                    
+                                    Component.onCompleted: refresh()
+                                }
+                            }
+                        }
+                    }
+                }
+                
                 // ==========================================
                 // CATALOG SECTION
                 // ==========================================
@@ -29,6 +29,13 @@ Item {
         return (minutes < 10 ? "0" : "") + minutes + ":" + (seconds < 10 ? "0" : "") + seconds
     }
     
+    // Helper function to format a download speed in bytes per second
+    function formatSpeed(bytesPerSecond) {
+        if (!bytesPerSecond || bytesPerSecond <= 0) return "0 KB/s"
+        if (bytesPerSecond >= 1024 * 1024) return (bytesPerSecond / (1024 * 1024)).toFixed(1) + " MB/s"
+        return Math.round(bytesPerSecond / 1024) + " KB/s"
+    }
+    
     // Video Element: Use the VideoPlayer item we registered. Make it fill the parent.
     // Rounded Corners: Apply layer.effect in Qt 6 to give it 24px rounded corners
     Rectangle {
@@ -371,7 +378,20 @@ Item {
                 radius: 2
                 color: "#33FFFFFF"
                 
+                // Downloaded ahead of the play head (torrents)
+                Rectangle {
+                    visible: videoPlayer.isTorrentSource && videoPlayer.duration > 0
+                    x: playedBar.width
+                    width: videoPlayer.duration > 0
+                           ? Math.min(parent.width - x, parent.width * strIndicator.bufferedSeconds * 1000 / videoPlayer.duration)
+                           : 0
+                    height: parent.height
+                    radius: 2
+                    color: "#66FFFFFF"
+                }
+                
                 Rectangle {
+                    id: playedBar
                     width: parent.width * (videoPlayer.duration > 0 ? videoPlayer.position / videoPlayer.duration : 0)
                     height: parent.height
                     radius: 2
@@ -390,7 +410,7 @@ Item {
             }
         }
         
-        // STR indicator
+        // STR indicator; torrents show what is buffered ahead and where it comes from
         Row {
             id: strIndicator
             anchors.right: parent.right
@@ -398,17 +418,26 @@ Item {
             anchors.verticalCenter: parent.verticalCenter
             spacing: 8
             
+            property var health: videoPlayer.bufferHealth
+            property bool hasHealth: videoPlayer.isTorrentSource && health.peers !== undefined
+            property real bufferedSeconds: hasHealth ? health.bufferedAheadSeconds : 0
+            
             Rectangle {
                 anchors.verticalCenter: parent.verticalCenter
                 width: 8
                 height: 8
                 radius: 4
-                color: "#10B981"  // Green color
+                // Green with plenty buffered, amber when running low, red when about to stall
+                color: !strIndicator.hasHealth || strIndicator.bufferedSeconds >= 10 ? "#10B981"
+                       : strIndicator.bufferedSeconds >= 3 ? "#F59E0B" : "#EF4444"
             }
             
             Text {
                 anchors.verticalCenter: parent.verticalCenter
-                text: "STR"
+                text: strIndicator.hasHealth
+                      ? Math.floor(strIndicator.bufferedSeconds) + "s buffered · "
+                        + strIndicator.health.peers + " peers · " + formatSpeed(strIndicator.health.downloadSpeed)
+                      : "STR"
                 color: "#FFFFFF"
                 font.pixelSize: 12
             }
@@ -0,0 +1,67 @@
+#include "addon_health_dao.h"
+#include "database_manager.h"
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QDebug>
+
+AddonHealthDao::AddonHealthDao() noexcept = default;
+
+bool AddonHealthDao::upsertHealth(const AddonHealthRecord& record)
+{
+    QSqlQuery query(getDatabase());
+    query.prepare(R"(
+        INSERT OR REPLACE INTO addon_health (
+            addon_id, resource, samples, p50_ms, p95_ms, error_rate,
+            timeout_rate, consecutive_failures, updated_at
+        ) VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?)
+    )");
+    query.addBindValue(record.addonId);
+    query.addBindValue(record.resource);
+    query.addBindValue(record.samples);
+    query.addBindValue(record.p50Ms);
+    query.addBindValue(record.p95Ms);
+    query.addBindValue(record.errorRate);
+    query.addBindValue(record.timeoutRate);
+    query.addBindValue(record.consecutiveFailures);
+    query.addBindValue(record.updatedAt.toString(Qt::ISODate));
+
+    if (!query.exec()) {
+        qWarning() << "Failed to upsert addon health:" << query.lastError().text();
+        return false;
+    }
+
+    return true;
+}
+
+QList<AddonHealthRecord> AddonHealthDao::getAllHealth() const
+{
+    QList<AddonHealthRecord> records;
+    QSqlQuery query(getDatabase());
+    query.prepare("SELECT * FROM addon_health");
+
+    if (!query.exec()) {
+        qWarning() << "Failed to get addon health:" << query.lastError().text();
+        return records;
+    }
+
+    while (query.next()) {
+        records.append(recordFromQuery(query));
+    }
+
+    return records;
+}
+
+AddonHealthRecord AddonHealthDao::recordFromQuery(const QSqlQuery& query) const noexcept
+{
+    AddonHealthRecord record;
+    record.addonId = query.value("addon_id").toString();
+    record.resource = query.value("resource").toString();
+    record.samples = query.value("samples").toString();
+    record.p50Ms = query.value("p50_ms").toInt();
+    record.p95Ms = query.value("p95_ms").toInt();
+    record.errorRate = query.value("error_rate").toDouble();
+    record.timeoutRate = query.value("timeout_rate").toDouble();
+    record.consecutiveFailures = query.value("consecutive_failures").toInt();
+    record.updatedAt = QDateTime::fromString(query.value("updated_at").toString(), Qt::ISODate);
+    return record;
+}
@@ -0,0 +1,45 @@
+#ifndef ADDON_HEALTH_DAO_H
+#define ADDON_HEALTH_DAO_H
+
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QString>
+#include <QDateTime>
+#include <QList>
+
+#include "database_manager.h"
+
+struct AddonHealthRecord
+{
+    QString addonId;
+    QString resource;           // "catalog", "meta", "stream" or "search"
+    QString samples;            // recent requests, encoded by AddonHealthService
+    int p50Ms = 0;
+    int p95Ms = 0;
+    double errorRate = 0.0;
+    double timeoutRate = 0.0;
+    int consecutiveFailures = 0;
+    QDateTime updatedAt;
+
+    AddonHealthRecord() = default;
+
+    [[nodiscard]] bool isValid() const noexcept { return !addonId.isEmpty() && !resource.isEmpty(); }
+};
+
+class AddonHealthDao
+{
+public:
+    explicit AddonHealthDao() noexcept;
+
+    [[nodiscard]] bool upsertHealth(const AddonHealthRecord& record);
+    [[nodiscard]] QList<AddonHealthRecord> getAllHealth() const;
+
+private:
+    [[nodiscard]] AddonHealthRecord recordFromQuery(const QSqlQuery& query) const noexcept;
+
+    [[nodiscard]] static QSqlDatabase getDatabase() noexcept {
+        return QSqlDatabase::database(DatabaseManager::CONNECTION_NAME);
+    }
+};
+
+#endif // ADDON_HEALTH_DAO_H
@@ -0,0 +1,137 @@
+#include "cache_entry_dao.h"
+#include "database_manager.h"
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QDebug>
+
+CacheEntryDao::CacheEntryDao(const QString& connectionName) noexcept
+    : m_connectionName(connectionName)
+{
+}
+
+bool CacheEntryDao::upsertEntries(const QList<CacheEntryRecord>& records)
+{
+    QSqlDatabase db = getDatabase();
+    db.transaction();
+
+    QSqlQuery query(db);
+    query.prepare(R"(
+        INSERT OR REPLACE INTO cache_entries (key, payload, expires_at, stored_at)
+        VALUES (?, ?, ?, ?)
+    )");
+
+    for (const CacheEntryRecord& record : records) {
+        query.bindValue(0, record.key);
+        query.bindValue(1, record.payload);
+        query.bindValue(2, record.expiresAt);
+        query.bindValue(3, record.storedAt);
+
+        if (!query.exec()) {
+            qWarning() << "Failed to upsert cache entry:" << query.lastError().text();
+            db.rollback();
+            return false;
+        }
+    }
+
+    db.commit();
+    return true;
+}
+
+bool CacheEntryDao::removeEntries(const QStringList& keys)
+{
+    QSqlDatabase db = getDatabase();
+    db.transaction();
+
+    QSqlQuery query(db);
+    query.prepare("DELETE FROM cache_entries WHERE key = ?");
+
+    for (const QString& key : keys) {
+        query.bindValue(0, key);
+        if (!query.exec()) {
+            qWarning() << "Failed to remove cache entry:" << query.lastError().text();
+            db.rollback();
+            return false;
+        }
+    }
+
+    db.commit();
+    return true;
+}
+
+bool CacheEntryDao::removeAll()
+{
+    QSqlQuery query(getDatabase());
+    if (!query.exec("DELETE FROM cache_entries")) {
+        qWarning() << "Failed to clear cache entries:" << query.lastError().text();
+        return false;
+    }
+    return true;
+}
+
+bool CacheEntryDao::removeByPrefix(const QString& prefix)
+{
+    QSqlQuery query(getDatabase());
+    query.prepare("DELETE FROM cache_entries WHERE substr(key, 1, ?) = ?");
+    query.addBindValue(prefix.size());
+    query.addBindValue(prefix);
+
+    if (!query.exec()) {
+        qWarning() << "Failed to remove cache entries by prefix:" << query.lastError().text();
+        return false;
+    }
+    return true;
+}
+
+bool CacheEntryDao::removeExpired(qint64 nowMs)
+{
+    QSqlQuery query(getDatabase());
+    query.prepare("DELETE FROM cache_entries WHERE expires_at <= ?");
+    query.addBindValue(nowMs);
+
+    if (!query.exec()) {
+        qWarning() << "Failed to remove expired cache entries:" << query.lastError().text();
+        return false;
+    }
+    return true;
+}
+
+CacheEntryRecord CacheEntryDao::getEntry(const QString& key) const
+{
+    CacheEntryRecord record;
+    QSqlQuery query(getDatabase());
+    query.prepare("SELECT key, payload, expires_at, stored_at FROM cache_entries WHERE key = ?");
+    query.addBindValue(key);
+
+    if (!query.exec()) {
+        qWarning() << "Failed to get cache entry:" << query.lastError().text();
+        return record;
+    }
+
+    if (query.next()) {
+        record.key = query.value("key").toString();
+        record.payload = query.value("payload").toByteArray();
+        record.expiresAt = query.value("expires_at").toLongLong();
+        record.storedAt = query.value("stored_at").toLongLong();
+    }
+
+    return record;
+}
+
+QStringList CacheEntryDao::getLiveKeys(qint64 nowMs) const
+{
+    QStringList keys;
+    QSqlQuery query(getDatabase());
+    query.prepare("SELECT key FROM cache_entries WHERE expires_at > ?");
+    query.addBindValue(nowMs);
+
+    if (!query.exec()) {
+        qWarning() << "Failed to get cache keys:" << query.lastError().text();
+        return keys;
+    }
+
+    while (query.next()) {
+        keys.append(query.value(0).toString());
+    }
+
+    return keys;
+}
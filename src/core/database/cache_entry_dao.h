@@ -0,0 +1,51 @@
+#ifndef CACHE_ENTRY_DAO_H
+#define CACHE_ENTRY_DAO_H
+
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QString>
+#include <QStringList>
+#include <QByteArray>
+#include <QList>
+
+#include "database_manager.h"
+
+struct CacheEntryRecord
+{
+    QString key;
+    QByteArray payload;         // QVariant serialised by CacheService
+    qint64 expiresAt = 0;       // ms since epoch
+    qint64 storedAt = 0;        // ms since epoch
+
+    CacheEntryRecord() = default;
+
+    [[nodiscard]] bool isValid() const noexcept { return !key.isEmpty(); }
+};
+
+class CacheEntryDao
+{
+public:
+    // The cache writer thread passes a connection of its own
+    explicit CacheEntryDao(const QString& connectionName = DatabaseManager::CONNECTION_NAME) noexcept;
+
+    [[nodiscard]] bool upsertEntries(const QList<CacheEntryRecord>& records);
+    [[nodiscard]] bool removeEntries(const QStringList& keys);
+    [[nodiscard]] bool removeAll();
+    [[nodiscard]] bool removeByPrefix(const QString& prefix);
+    [[nodiscard]] bool removeExpired(qint64 nowMs);
+    [[nodiscard]] CacheEntryRecord getEntry(const QString& key) const;
+    [[nodiscard]] QStringList getLiveKeys(qint64 nowMs) const;
+
+    [[nodiscard]] bool isAvailable() const noexcept {
+        return QSqlDatabase::database(m_connectionName, false).isOpen();
+    }
+
+private:
+    [[nodiscard]] QSqlDatabase getDatabase() const noexcept {
+        return QSqlDatabase::database(m_connectionName);
+    }
+
+    QString m_connectionName;
+};
+
+#endif // CACHE_ENTRY_DAO_H
@@ -189,6 +189,30 @@ bool DatabaseManager::createTables()
                 created_at TEXT NOT NULL,
                 updated_at TEXT NOT NULL
             ))"
+        },
+        {
+            "addon_health",
+            R"(CREATE TABLE IF NOT EXISTS addon_health (
+                addon_id TEXT NOT NULL,
+                resource TEXT NOT NULL,
+                samples TEXT NOT NULL,
+                p50_ms INTEGER DEFAULT 0,
+                p95_ms INTEGER DEFAULT 0,
+                error_rate REAL DEFAULT 0,
+                timeout_rate REAL DEFAULT 0,
+                consecutive_failures INTEGER DEFAULT 0,
+                updated_at TEXT NOT NULL,
+                PRIMARY KEY (addon_id, resource)
+            ))"
+        },
+        {
+            "cache_entries",
+            R"(CREATE TABLE IF NOT EXISTS cache_entries (
+                key TEXT PRIMARY KEY,
+                payload BLOB NOT NULL,
+                expires_at INTEGER NOT NULL,
+                stored_at INTEGER NOT NULL
+            ))"
         }
     };
 
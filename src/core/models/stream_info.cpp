@@ -29,6 +29,7 @@ QVariantMap StreamInfo::toVariantMap() const
     
     map["isFree"] = isFree;
     map["isDebrid"] = isDebrid;
+    map["isTorrent"] = isTorrent;
     map["subtitles"] = subtitles;
     map["behaviorHints"] = behaviorHints;
     return map;
@@ -101,7 +102,7 @@ StreamInfo StreamInfo::fromJson(const QJsonObject& json, const QString& defaultA
     
     info.infoHash = json["infoHash"].toString();
     info.fileIdx = json["fileIdx"].toInt(-1);
-    info.size = json["size"].toInt(-1);
+    info.size = json["size"].toInteger(-1);
     info.isFree = json["isFree"].toBool(false);
     info.isDebrid = json["isDebrid"].toBool(false);
     
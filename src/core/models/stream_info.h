@@ -21,9 +21,10 @@ struct StreamInfo
     QString infoHash;
     
     int fileIdx = -1;
-    int size = -1;
+    qint64 size = -1;
     bool isFree = false;
     bool isDebrid = false;
+    bool isTorrent = false; // url is an unresolved magnet, activated on playback
     
     QVariantList subtitles;
     QVariantMap behaviorHints;
@@ -0,0 +1,297 @@
+#include "addon_health_service.h"
+#include "logging_service.h"
+#include "core/database/addon_health_dao.h"
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QStringList>
+#include <QTimer>
+#include <QVariantMap>
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+AddonHealthService::AddonHealthService(QObject* parent)
+    : QObject(parent)
+    , m_dao(std::make_unique<AddonHealthDao>())
+    , m_flushTimer(new QTimer(this))
+{
+    // Samples are written in batches; a burst of requests costs one write per addon
+    m_flushTimer->setSingleShot(true);
+    m_flushTimer->setInterval(kFlushDelayMs);
+    connect(m_flushTimer, &QTimer::timeout, this, &AddonHealthService::flush);
+    if (QCoreApplication::instance()) {
+        connect(QCoreApplication::instance(), &QCoreApplication::aboutToQuit,
+                this, &AddonHealthService::flush);
+    }
+
+    load();
+}
+
+AddonHealthService::~AddonHealthService()
+{
+    flush();
+}
+
+QString AddonHealthService::entryKey(const QString& addonId, const QString& resource)
+{
+    return addonId + '|' + resource;
+}
+
+void AddonHealthService::recordResult(const QString& addonId, const QString& resource,
+                                      qint64 latencyMs, Outcome outcome)
+{
+    if (addonId.isEmpty()) {
+        return;
+    }
+
+    QString key = entryKey(addonId, resource);
+    Entry& entry = m_entries[key];
+    entry.addonId = addonId;
+    entry.resource = resource;
+    entry.samples.append({static_cast<int>(qBound<qint64>(0, latencyMs, std::numeric_limits<int>::max())), outcome});
+    if (entry.samples.size() > kWindowSize) {
+        entry.samples.removeFirst();
+    }
+
+    if (outcome == Outcome::Success) {
+        if (entry.openedAt.isValid()) {
+            LoggingService::logInfo("AddonHealthService",
+                QString("Addon %1 (%2) recovered, closing circuit").arg(addonId, resource));
+        }
+        entry.consecutiveFailures = 0;
+        entry.trips = 0;
+        entry.halfOpen = false;
+        entry.openedAt.invalidate();
+    } else {
+        ++entry.consecutiveFailures;
+        // Requests sent before the breaker opened may still fail; only the
+        // threshold crossing and a failed probe (re)open it
+        bool trip = entry.openedAt.isValid() ? entry.halfOpen
+                                             : entry.consecutiveFailures >= kBreakerThreshold;
+        if (trip) {
+            ++entry.trips;
+            entry.halfOpen = false;
+            entry.cooldownMs = qMin(kMaxCooldownMs, kBaseCooldownMs << qMin(entry.trips - 1, 10));
+            entry.openedAt.start();
+            LoggingService::logWarning("AddonHealthService",
+                QString("Addon %1 (%2) failed %3 time(s) in a row, skipping it for %4s")
+                    .arg(addonId, resource).arg(entry.consecutiveFailures).arg(entry.cooldownMs / 1000));
+        }
+    }
+
+    updateDerived(entry);
+    m_dirty.insert(key);
+    if (!m_flushTimer->isActive()) {
+        m_flushTimer->start();
+    }
+}
+
+bool AddonHealthService::allowRequest(const QString& addonId, const QString& resource)
+{
+    auto it = m_entries.find(entryKey(addonId, resource));
+    if (it == m_entries.end() || !it->openedAt.isValid()) {
+        return true;
+    }
+    if (it->openedAt.elapsed() < it->cooldownMs) {
+        return false;
+    }
+
+    // Half-open: let one probe through and hold the rest until it answers or times out
+    it->halfOpen = true;
+    it->cooldownMs = timeoutFor(addonId, resource) + 1000;
+    it->openedAt.start();
+    LoggingService::logDebug("AddonHealthService",
+        QString("Probing addon %1 (%2)").arg(addonId, resource));
+    return true;
+}
+
+int AddonHealthService::timeoutFor(const QString& addonId, const QString& resource) const
+{
+    auto it = m_entries.constFind(entryKey(addonId, resource));
+    if (it == m_entries.constEnd() || it->successCount < kMinSamples) {
+        return kDefaultTimeoutMs;
+    }
+    // Twice the p95 leaves room for the tail without waiting out a dead addon
+    return qBound(kMinTimeoutMs, it->p95Ms * 2 + 1000, kDefaultTimeoutMs);
+}
+
+bool AddonHealthService::isOpen(const Entry& entry) const
+{
+    return entry.openedAt.isValid() && !entry.halfOpen && entry.openedAt.elapsed() < entry.cooldownMs;
+}
+
+void AddonHealthService::sortAddons(QList<AddonConfig>& addons, const QString& resource) const
+{
+    auto rankOf = [this, &resource](const AddonConfig& addon) {
+        auto it = m_entries.constFind(entryKey(addon.id, resource));
+        if (it == m_entries.constEnd()) {
+            return std::make_pair(0, 0);
+        }
+        int tier = 0;
+        if (isOpen(*it)) {
+            tier = 2;
+        } else if (it->errorRate + it->timeoutRate > 0.5) {
+            tier = 1;
+        }
+        // 250 ms buckets, so addons that are about as fast keep their configured order
+        int latencyBucket = it->successCount < kMinSamples ? 0 : it->p50Ms / 250;
+        return std::make_pair(tier, latencyBucket);
+    };
+
+    std::vector<std::pair<std::pair<int, int>, AddonConfig>> ranked;
+    ranked.reserve(static_cast<size_t>(addons.size()));
+    for (const AddonConfig& addon : std::as_const(addons)) {
+        ranked.emplace_back(rankOf(addon), addon);
+    }
+    std::stable_sort(ranked.begin(), ranked.end(), [](const auto& a, const auto& b) {
+        return a.first < b.first;
+    });
+
+    addons.clear();
+    for (const auto& entry : ranked) {
+        addons.append(entry.second);
+    }
+}
+
+QVariantList AddonHealthService::healthReport() const
+{
+    QVariantList report;
+    for (auto it = m_entries.constBegin(); it != m_entries.constEnd(); ++it) {
+        QVariantMap item;
+        item["addonId"] = it->addonId;
+        item["resource"] = it->resource;
+        item["samples"] = static_cast<int>(it->samples.size());
+        item["p50Ms"] = it->p50Ms;
+        item["p95Ms"] = it->p95Ms;
+        item["errorRate"] = it->errorRate;
+        item["timeoutRate"] = it->timeoutRate;
+        item["timeoutMs"] = timeoutFor(it->addonId, it->resource);
+        item["breakerOpen"] = isOpen(*it);
+        report.append(item);
+    }
+    return report;
+}
+
+void AddonHealthService::updateDerived(Entry& entry)
+{
+    std::vector<int> latencies;
+    latencies.reserve(static_cast<size_t>(entry.samples.size()));
+    int errors = 0;
+    int timeouts = 0;
+    for (const Sample& sample : std::as_const(entry.samples)) {
+        switch (sample.outcome) {
+        case Outcome::Success:
+            latencies.push_back(sample.latencyMs);
+            break;
+        case Outcome::Error:
+            ++errors;
+            break;
+        case Outcome::Timeout:
+            ++timeouts;
+            break;
+        }
+    }
+
+    std::sort(latencies.begin(), latencies.end());
+    entry.successCount = static_cast<int>(latencies.size());
+    if (latencies.empty()) {
+        entry.p50Ms = 0;
+        entry.p95Ms = 0;
+    } else {
+        size_t last = latencies.size() - 1;
+        entry.p50Ms = latencies[last * 50 / 100];
+        entry.p95Ms = latencies[last * 95 / 100];
+    }
+
+    double total = entry.samples.isEmpty() ? 1.0 : static_cast<double>(entry.samples.size());
+    entry.errorRate = errors / total;
+    entry.timeoutRate = timeouts / total;
+}
+
+QString AddonHealthService::encodeSamples(const QList<Sample>& samples)
+{
+    // "<latency><s|e|t>" per request, oldest first
+    QStringList parts;
+    parts.reserve(samples.size());
+    for (const Sample& sample : samples) {
+        QChar outcome = sample.outcome == Outcome::Success ? 's'
+            : sample.outcome == Outcome::Timeout ? 't' : 'e';
+        parts.append(QString::number(sample.latencyMs) + outcome);
+    }
+    return parts.join(',');
+}
+
+QList<AddonHealthService::Sample> AddonHealthService::decodeSamples(const QString& encoded)
+{
+    QList<Sample> samples;
+    const QStringList parts = encoded.split(',', Qt::SkipEmptyParts);
+    for (const QString& part : parts) {
+        bool ok = false;
+        int latencyMs = part.first(part.size() - 1).toInt(&ok);
+        if (!ok) {
+            continue;
+        }
+        QChar outcome = part.back();
+        samples.append({latencyMs, outcome == 's' ? Outcome::Success
+                                   : outcome == 't' ? Outcome::Timeout : Outcome::Error});
+    }
+    if (samples.size() > kWindowSize) {
+        samples.remove(0, samples.size() - kWindowSize);
+    }
+    return samples;
+}
+
+void AddonHealthService::load()
+{
+    const QList<AddonHealthRecord> records = m_dao->getAllHealth();
+    for (const AddonHealthRecord& record : records) {
+        if (!record.isValid()) {
+            continue;
+        }
+        Entry& entry = m_entries[entryKey(record.addonId, record.resource)];
+        entry.addonId = record.addonId;
+        entry.resource = record.resource;
+        entry.samples = decodeSamples(record.samples);
+        entry.consecutiveFailures = record.consecutiveFailures;
+        if (entry.consecutiveFailures >= kBreakerThreshold) {
+            // Was failing when the app closed: the first request is a probe
+            entry.trips = 1;
+            entry.cooldownMs = 0;
+            entry.openedAt.start();
+        }
+        updateDerived(entry);
+    }
+    LoggingService::logDebug("AddonHealthService",
+        QString("Loaded health for %1 addon resource(s)").arg(m_entries.size()));
+}
+
+void AddonHealthService::flush()
+{
+    m_flushTimer->stop();
+    if (m_dirty.isEmpty()) {
+        return;
+    }
+
+    QDateTime now = QDateTime::currentDateTime();
+    for (const QString& key : std::as_const(m_dirty)) {
+        auto it = m_entries.constFind(key);
+        if (it == m_entries.constEnd()) {
+            continue;
+        }
+        AddonHealthRecord record;
+        record.addonId = it->addonId;
+        record.resource = it->resource;
+        record.samples = encodeSamples(it->samples);
+        record.p50Ms = it->p50Ms;
+        record.p95Ms = it->p95Ms;
+        record.errorRate = it->errorRate;
+        record.timeoutRate = it->timeoutRate;
+        record.consecutiveFailures = it->consecutiveFailures;
+        record.updatedAt = now;
+        if (!m_dao->upsertHealth(record)) {
+            LoggingService::logWarning("AddonHealthService",
+                QString("Failed to save health for addon %1 (%2)").arg(record.addonId, record.resource));
+        }
+    }
+    m_dirty.clear();
+}
@@ -0,0 +1,125 @@
+#ifndef ADDON_HEALTH_SERVICE_H
+#define ADDON_HEALTH_SERVICE_H
+
+#include <QObject>
+#include <QString>
+#include <QList>
+#include <QHash>
+#include <QSet>
+#include <QVariantList>
+#include <QElapsedTimer>
+#include <memory>
+#include "features/addons/models/addon_config.h"
+
+class AddonHealthDao;
+class QTimer;
+
+/**
+ * @brief Shared record of how each addon behaves, per resource
+ *
+ * AddonClient reports every catalog, meta, stream and search request of a
+ * client that knows its addon id. The last kWindowSize outcomes per addon and
+ * resource give p50/p95 latency (of successful requests), error rate and
+ * timeout rate; they are persisted in the addon_health table so a restart
+ * starts from what was learned before.
+ *
+ * Consumers use it to order their fan-out (healthy, fast addons first), to
+ * skip addons whose circuit breaker is open, and to size per-request timeouts.
+ */
+class AddonHealthService : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum class Outcome {
+        Success,
+        Error,
+        Timeout
+    };
+
+    explicit AddonHealthService(QObject* parent = nullptr);
+    ~AddonHealthService() override;
+
+    /**
+     * @brief Record the result of one addon request
+     * @param latencyMs Time from sending the request to its reply
+     */
+    void recordResult(const QString& addonId, const QString& resource, qint64 latencyMs, Outcome outcome);
+
+    /**
+     * @brief Circuit breaker check before sending a request
+     *
+     * After kBreakerThreshold consecutive failures the breaker opens and
+     * requests are skipped for a cooldown that doubles on every trip. Once it
+     * has passed, a single probe request is let through; its result closes or
+     * re-opens the breaker.
+     */
+    bool allowRequest(const QString& addonId, const QString& resource);
+
+    /**
+     * @brief Transfer timeout for the next request, from the observed p95
+     */
+    int timeoutFor(const QString& addonId, const QString& resource) const;
+
+    /**
+     * @brief Stable-sort addons: fewer failures first, then lower p50
+     *
+     * Addons without enough samples keep their configured position ahead of
+     * slow ones, so a new addon gets measured.
+     */
+    void sortAddons(QList<AddonConfig>& addons, const QString& resource) const;
+
+    /**
+     * @brief Current numbers per addon and resource
+     * @return List of maps with addonId, resource, samples, p50Ms, p95Ms,
+     *         errorRate, timeoutRate, timeoutMs and breakerOpen
+     */
+    Q_INVOKABLE QVariantList healthReport() const;
+
+private:
+    struct Sample {
+        int latencyMs;
+        Outcome outcome;
+    };
+
+    struct Entry {
+        QString addonId;
+        QString resource;
+        QList<Sample> samples;          // oldest first, at most kWindowSize
+        int consecutiveFailures = 0;
+        int trips = 0;                  // breaker openings since the last success
+        QElapsedTimer openedAt;         // valid while the breaker is open
+        qint64 cooldownMs = 0;
+        bool halfOpen = false;          // a probe request is in flight
+        // Derived from samples
+        int p50Ms = 0;
+        int p95Ms = 0;
+        int successCount = 0;
+        double errorRate = 0.0;
+        double timeoutRate = 0.0;
+    };
+
+    static QString entryKey(const QString& addonId, const QString& resource);
+    static void updateDerived(Entry& entry);
+    static QString encodeSamples(const QList<Sample>& samples);
+    static QList<Sample> decodeSamples(const QString& encoded);
+    bool isOpen(const Entry& entry) const;
+    void load();
+    void flush();
+
+    static constexpr int kWindowSize = 50;
+    static constexpr int kMinSamples = 5;
+    static constexpr int kBreakerThreshold = 3;
+    static constexpr qint64 kBaseCooldownMs = 30 * 1000;
+    static constexpr qint64 kMaxCooldownMs = 10 * 60 * 1000;
+    static constexpr int kDefaultTimeoutMs = 15000;
+    static constexpr int kMinTimeoutMs = 3000;
+    static constexpr int kFlushDelayMs = 30 * 1000;
+
+    std::unique_ptr<AddonHealthDao> m_dao;
+    QHash<QString, Entry> m_entries;    // "<addonId>|<resource>"
+    QSet<QString> m_dirty;
+    QTimer* m_flushTimer;
+};
+
+#endif // ADDON_HEALTH_SERVICE_H
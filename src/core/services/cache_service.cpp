@@ -1,75 +1,299 @@
 #include "cache_service.h"
 #include "logging_service.h"
+#include "core/services/configuration.h"
+#include "core/database/cache_entry_dao.h"
 #include "core/di/service_registry.h"
+#include <QCoreApplication>
+#include <QDataStream>
+#include <QDateTime>
+#include <QMutexLocker>
+#include <QSqlDatabase>
+#include <QSqlError>
+#include <QThread>
+#include <QTimer>
 #include <QUrlQuery>
 
+namespace {
+const QString kWriterConnectionName = QStringLiteral("yantrium_cache_writer");
+}
+
+/**
+ * @brief Commits flushed batches on the cache's writer thread
+ *
+ * A QSqlDatabase connection may only be used by the thread that opened it,
+ * so the writer clones the application's connection on first use.
+ */
+class CacheService::DiskWriter : public QObject
+{
+public:
+    struct Result {
+        QStringList written;
+        QStringList removed;
+    };
+
+    ~DiskWriter() override
+    {
+        if (m_dao) {
+            m_dao.reset();
+            QSqlDatabase::removeDatabase(kWriterConnectionName);
+        }
+    }
+
+    Result write(const DiskBatch& batch);
+
+private:
+    bool open();
+
+    std::unique_ptr<CacheEntryDao> m_dao;
+};
+
+bool CacheService::DiskWriter::open()
+{
+    if (!m_dao) {
+        QSqlDatabase::cloneDatabase(DatabaseManager::CONNECTION_NAME, kWriterConnectionName);
+        m_dao = std::make_unique<CacheEntryDao>(kWriterConnectionName);
+    }
+    QSqlDatabase db = QSqlDatabase::database(kWriterConnectionName); // opens it if needed
+    if (!db.isOpen()) {
+        LoggingService::logWarning("CacheService", QString("Cannot open the cache writer's database connection: %1")
+            .arg(db.lastError().text()));
+        return false;
+    }
+    return true;
+}
+
+CacheService::DiskWriter::Result CacheService::DiskWriter::write(const DiskBatch& batch)
+{
+    Result result;
+    if (!open()) {
+        return result;
+    }
+
+    if (batch.clear && !m_dao->removeAll()) {
+        LoggingService::logWarning("CacheService", "Failed to clear persisted cache entries");
+    }
+    for (const QString& prefix : batch.prefixRemovals) {
+        if (!m_dao->removeByPrefix(prefix)) {
+            LoggingService::logWarning("CacheService", QString("Failed to remove persisted cache entries under %1").arg(prefix));
+        }
+    }
+
+    qint64 now = QDateTime::currentMSecsSinceEpoch();
+    QList<CacheEntryRecord> records;
+    records.reserve(batch.writes.size());
+    for (auto it = batch.writes.constBegin(); it != batch.writes.constEnd(); ++it) {
+        if (it->expiresAt <= now) {
+            continue;
+        }
+        CacheEntryRecord record;
+        record.key = it.key();
+        QDataStream stream(&record.payload, QIODevice::WriteOnly);
+        stream.setVersion(QDataStream::Qt_6_0);
+        stream << it->data;
+        if (stream.status() != QDataStream::Ok) {
+            LoggingService::logWarning("CacheService", QString("Cannot persist cache entry: %1").arg(it.key()));
+            continue;
+        }
+        record.expiresAt = it->expiresAt;
+        record.storedAt = now;
+        records.append(record);
+    }
+
+    if (!records.isEmpty()) {
+        if (m_dao->upsertEntries(records)) {
+            for (const CacheEntryRecord& record : std::as_const(records)) {
+                result.written.append(record.key);
+            }
+        } else {
+            LoggingService::logWarning("CacheService", "Failed to persist cache entries");
+        }
+    }
+    if (!batch.removals.isEmpty()) {
+        if (m_dao->removeEntries(batch.removals)) {
+            result.removed = batch.removals;
+        } else {
+            LoggingService::logWarning("CacheService", "Failed to remove persisted cache entries");
+        }
+    }
+
+    LoggingService::logDebug("CacheService", QString("Persisted %1 cache entries, removed %2")
+        .arg(result.written.size()).arg(result.removed.size()));
+    return result;
+}
+
 CacheService& CacheService::instance()
 {
-    static CacheService* s_instance = nullptr;
+    // Same object as resolve<CacheService>(); a second cache would hold its
+    // own copies and miss every clear(), so there is no fallback instance
+    static std::shared_ptr<CacheService> s_instance = registered();
     if (!s_instance) {
-        s_instance = new CacheService();
+        qFatal("CacheService::instance() used before CacheService was registered");
     }
     return *s_instance;
 }
 
+std::shared_ptr<CacheService> CacheService::registered()
+{
+    auto service = ServiceRegistry::instance().resolve<CacheService>();
+    if (!service) {
+        LoggingService::logError("CacheService", "CacheService is not registered; cache access ignored");
+    }
+    return service;
+}
+
 CacheService::CacheService(QObject* parent)
     : QObject(parent)
+    , m_maxEntries(5000)
+    , m_maxBytes(64LL * 1024 * 1024)
+    , m_dao(std::make_unique<CacheEntryDao>())
+    , m_flushTimer(new QTimer(this))
+    , m_diskThread(new QThread(this))
+    , m_diskWriter(new DiskWriter)
 {
-    LoggingService::logInfo("CacheService", "Initialized");
+    m_clock.start();
+
+    // Persisted entries are written in batches, off the path of the caller,
+    // and committed on the writer thread
+    m_diskThread->setObjectName("CacheDiskWriter");
+    m_diskWriter->moveToThread(m_diskThread);
+    connect(m_diskThread, &QThread::finished, m_diskWriter, &QObject::deleteLater);
+    m_diskThread->start(QThread::LowPriority);
+
+    m_flushTimer->setSingleShot(true);
+    m_flushTimer->setInterval(kFlushDelayMs);
+    connect(m_flushTimer, &QTimer::timeout, this, &CacheService::flushToDisk);
+    if (QCoreApplication::instance()) {
+        connect(QCoreApplication::instance(), &QCoreApplication::aboutToQuit,
+                this, &CacheService::finishDiskWrites);
+    }
+
+    if (auto config = ServiceRegistry::instance().resolve<Configuration>()) {
+        m_maxEntries = config->cacheMaxEntries();
+        m_maxBytes = config->cacheMaxBytes();
+        m_namespaceBudgets = config->cacheNamespaceBudgets();
+    }
+    LoggingService::logInfo("CacheService", QString("Initialized (max %1 entries, %2 MB)")
+        .arg(m_maxEntries.load()).arg(m_maxBytes.load() / (1024 * 1024)));
 }
 
-void CacheService::set(const QString& key, const QVariant& data, int ttlSeconds)
+CacheService::~CacheService()
+{
+    finishDiskWrites();
+    m_diskThread->quit();
+    m_diskThread->wait();
+}
+
+CacheService::Shard& CacheService::shardFor(const QString& key) const
+{
+    return m_shards[qHash(key) % kShardCount];
+}
+
+void CacheService::set(const QString& key, const QVariant& data, int ttlSeconds, bool persist)
 {
     if (key.isEmpty()) {
         LoggingService::logWarning("CacheService", "set called with empty key");
         return;
     }
 
-    CacheEntry entry;
-    entry.data = data;
-    entry.timestamp = QDateTime::currentDateTime();
-    entry.ttlSeconds = ttlSeconds;
-    entry.isJson = false;
-
-    m_cache[key] = entry;
+    {
+        Shard& shard = shardFor(key);
+        QMutexLocker locker(&shard.mutex);
+        insertLocked(shard, key, data, ttlSeconds * 1000LL, false);
+    }
+    updatePersisted(key, data, ttlSeconds, persist);
     LoggingService::logDebug("CacheService", QString("Cached entry: %1 (TTL: %2s)").arg(key).arg(ttlSeconds));
 }
 
-void CacheService::setJson(const QString& key, const QJsonObject& data, int ttlSeconds)
+void CacheService::setJson(const QString& key, const QJsonObject& data, int ttlSeconds, bool persist)
 {
     if (key.isEmpty()) {
         LoggingService::logWarning("CacheService", "setJson called with empty key");
         return;
     }
 
+    QVariant value = QVariant::fromValue(data);
+    {
+        Shard& shard = shardFor(key);
+        QMutexLocker locker(&shard.mutex);
+        insertLocked(shard, key, value, ttlSeconds * 1000LL, true);
+    }
+    updatePersisted(key, value, ttlSeconds, persist);
+    LoggingService::logDebug("CacheService", QString("Cached JSON entry: %1 (TTL: %2s)").arg(key).arg(ttlSeconds));
+}
+
+void CacheService::insertLocked(Shard& shard, const QString& key, const QVariant& data, qint64 ttlMs,
+                                bool isJson) const
+{
+    purgeExpiredLocked(shard);
+
+    auto existing = shard.entries.find(key);
+    if (existing != shard.entries.end()) {
+        eraseLocked(shard, existing);
+    }
+
     CacheEntry entry;
-    entry.data = QVariant::fromValue(data);
-    entry.timestamp = QDateTime::currentDateTime();
-    entry.ttlSeconds = ttlSeconds;
-    entry.isJson = true;
+    entry.data = data;
+    entry.expiresAtMs = m_clock.elapsed() + qMax<qint64>(0, ttlMs);
+    entry.sizeBytes = key.size() * 2 + approximateSize(data);
+    entry.isJson = isJson;
+    entry.ns = namespaceOf(key);
+    shard.lru.push_front(key);
+    entry.lruPosition = shard.lru.begin();
+    Partition& partition = shard.partitions[entry.ns];
+    partition.lru.push_front(key);
+    partition.bytes += entry.sizeBytes;
+    entry.nsLruPosition = partition.lru.begin();
+
+    shard.totalBytes += entry.sizeBytes;
+    shard.expiryHeap.emplace(entry.expiresAtMs, key);
+    QString ns = entry.ns;
+    shard.entries.insert(key, entry);
+
+    evictOverCapacityLocked(shard, ns);
+    compactExpiryHeapLocked(shard);
+}
 
-    m_cache[key] = entry;
-    LoggingService::logDebug("CacheService", QString("Cached JSON entry: %1 (TTL: %2s)").arg(key).arg(ttlSeconds));
+QVariant CacheService::get(const QString& key)
+{
+    return get(key, nullptr);
 }
 
-QVariant CacheService::get(const QString& key) const
+QVariant CacheService::get(const QString& key, bool* fromDisk)
 {
-    cleanupExpired();
+    if (fromDisk) {
+        *fromDisk = false;
+    }
 
-    if (!m_cache.contains(key)) {
-        return QVariant();
+    Shard& shard = shardFor(key);
+    {
+        QMutexLocker locker(&shard.mutex);
+        auto it = shard.entries.find(key);
+        if (it != shard.entries.end()) {
+            if (it->expiresAtMs > m_clock.elapsed()) {
+                ++shard.hits;
+                shard.lru.splice(shard.lru.begin(), shard.lru, it->lruPosition);
+                LruList& nsLru = shard.partitions[it->ns].lru;
+                nsLru.splice(nsLru.begin(), nsLru, it->nsLruPosition);
+                return it->data;
+            }
+            ++shard.expirations;
+            eraseLocked(shard, it);
+        }
     }
 
-    const CacheEntry& entry = m_cache[key];
-    if (entry.isExpired()) {
-        m_cache.remove(key);
+    // The shard lock is not held across the disk lookup
+    bool loaded = loadPersisted(key, fromDisk);
+    QMutexLocker locker(&shard.mutex);
+    auto it = shard.entries.constFind(key);
+    if (!loaded || it == shard.entries.constEnd()) {
+        ++shard.misses;
         return QVariant();
     }
-
-    return entry.data;
+    ++shard.hits;
+    return it->data;
 }
 
-QJsonObject CacheService::getJson(const QString& key) const
+QJsonObject CacheService::getJson(const QString& key)
 {
     QVariant data = get(key);
     if (!data.isValid()) {
@@ -83,37 +307,240 @@ QJsonObject CacheService::getJson(const QString& key) const
     return QJsonObject();
 }
 
-bool CacheService::contains(const QString& key) const
+bool CacheService::contains(const QString& key)
 {
-    cleanupExpired();
-    return m_cache.contains(key) && !m_cache[key].isExpired();
+    {
+        Shard& shard = shardFor(key);
+        QMutexLocker locker(&shard.mutex);
+        auto it = shard.entries.constFind(key);
+        if (it != shard.entries.constEnd() && it->expiresAtMs > m_clock.elapsed()) {
+            return true;
+        }
+    }
+    return loadPersisted(key);
 }
 
 void CacheService::remove(const QString& key)
 {
-    if (m_cache.remove(key) > 0) {
-        emit cacheEntryRemoved(key);
-        LoggingService::logDebug("CacheService", QString("Removed cache entry: %1").arg(key));
+    bool removed = updatePersisted(key, QVariant(), 0, false);
+    {
+        Shard& shard = shardFor(key);
+        QMutexLocker locker(&shard.mutex);
+        auto it = shard.entries.find(key);
+        if (it != shard.entries.end()) {
+            eraseLocked(shard, it);
+            removed = true;
+        }
     }
+    if (!removed) {
+        return;
+    }
+    emit cacheEntryRemoved(key);
+    LoggingService::logDebug("CacheService", QString("Removed cache entry: %1").arg(key));
 }
 
 void CacheService::clear()
 {
-    int size = m_cache.size();
-    m_cache.clear();
+    int size = 0;
+    for (Shard& shard : m_shards) {
+        QMutexLocker locker(&shard.mutex);
+        size += shard.entries.size();
+        shard.entries.clear();
+        shard.lru.clear();
+        shard.partitions.clear();
+        shard.expiryHeap = {};
+        shard.totalBytes = 0;
+    }
+
+    {
+        QMutexLocker locker(&m_diskMutex);
+        m_pendingWrites.clear();
+        m_pendingRemovals.clear();
+        m_pendingPrefixRemovals.clear();
+        m_inFlightWrites.clear();
+        m_inFlightRemovals.clear();
+        m_diskKeys.clear();
+        m_diskIndexLoaded = true;
+        m_diskClearPending = true;
+    }
+    if (canUseDisk()) {
+        flushToDisk();
+    } else {
+        scheduleFlush();
+    }
+
     emit cacheCleared();
     LoggingService::logInfo("CacheService", QString("Cleared %1 cache entries").arg(size));
 }
 
 void CacheService::clearExpired()
 {
-    cleanupExpired();
+    for (Shard& shard : m_shards) {
+        QMutexLocker locker(&shard.mutex);
+        purgeExpiredLocked(shard);
+    }
+}
+
+int CacheService::invalidateNamespace(const QString& ns)
+{
+    return invalidate(ns, QString());
+}
+
+int CacheService::invalidatePrefix(const QString& prefix)
+{
+    if (prefix.isEmpty()) {
+        return 0;
+    }
+    return invalidate(namespaceOf(prefix), prefix);
+}
+
+int CacheService::invalidate(const QString& ns, const QString& prefix)
+{
+    int removed = 0;
+    for (Shard& shard : m_shards) {
+        QMutexLocker locker(&shard.mutex);
+        removed += invalidateLocked(shard, ns, prefix);
+    }
+
+    // Disk: forget the keys now, delete the rows with the next flush
+    QString diskPrefix = prefix.isEmpty() ? ns + ':' : prefix;
+    {
+        QMutexLocker locker(&m_diskMutex);
+        auto startsWithPrefix = [&diskPrefix](const QString& key) { return key.startsWith(diskPrefix); };
+        m_pendingWrites.removeIf([&diskPrefix](QHash<QString, PendingWrite>::iterator it) {
+            return it.key().startsWith(diskPrefix);
+        });
+        m_inFlightWrites.removeIf([&diskPrefix](QHash<QString, PendingWrite>::iterator it) {
+            return it.key().startsWith(diskPrefix);
+        });
+        m_diskKeys.removeIf(startsWithPrefix);
+        m_pendingRemovals.removeIf(startsWithPrefix);
+        m_pendingPrefixRemovals.append(diskPrefix);
+    }
+    scheduleFlush();
+
+    LoggingService::logInfo("CacheService", QString("Invalidated %1 cache entries under %2")
+        .arg(removed).arg(diskPrefix));
+    return removed;
+}
+
+int CacheService::invalidateLocked(Shard& shard, const QString& ns, const QString& prefix) const
+{
+    auto partition = shard.partitions.find(ns);
+    if (partition == shard.partitions.end()) {
+        return 0;
+    }
+
+    // Copy the keys first: erasing the last entry drops the partition
+    const QStringList keys(partition->lru.begin(), partition->lru.end());
+    int removed = 0;
+    for (const QString& key : keys) {
+        if (!prefix.isEmpty() && !key.startsWith(prefix)) {
+            continue;
+        }
+        auto it = shard.entries.find(key);
+        if (it != shard.entries.end()) {
+            eraseLocked(shard, it);
+            ++removed;
+        }
+    }
+    return removed;
+}
+
+int CacheService::namespaceSize(const QString& ns) const
+{
+    int total = 0;
+    for (Shard& shard : m_shards) {
+        QMutexLocker locker(&shard.mutex);
+        purgeExpiredLocked(shard);
+        auto partition = shard.partitions.constFind(ns);
+        if (partition != shard.partitions.constEnd()) {
+            total += static_cast<int>(partition->lru.size());
+        }
+    }
+    return total;
+}
+
+QString CacheService::namespaceOf(const QString& key)
+{
+    qsizetype separator = key.indexOf(':');
+    return separator < 0 ? QString() : key.left(separator);
 }
 
 int CacheService::size() const
 {
-    cleanupExpired();
-    return m_cache.size();
+    int total = 0;
+    for (Shard& shard : m_shards) {
+        QMutexLocker locker(&shard.mutex);
+        purgeExpiredLocked(shard);
+        total += shard.entries.size();
+    }
+    return total;
+}
+
+void CacheService::setCapacity(int maxEntries, qint64 maxBytes)
+{
+    m_maxEntries = qMax(0, maxEntries);
+    m_maxBytes = qMax<qint64>(0, maxBytes);
+    for (Shard& shard : m_shards) {
+        QMutexLocker locker(&shard.mutex);
+        evictOverCapacityLocked(shard);
+    }
+}
+
+QVariantMap CacheService::stats() const
+{
+    int entries = 0;
+    qint64 bytes = 0;
+    quint64 hits = 0;
+    quint64 misses = 0;
+    quint64 evictions = 0;
+    quint64 expirations = 0;
+    QHash<QString, QPair<int, qint64>> namespaces;  // entries, bytes
+    for (Shard& shard : m_shards) {
+        QMutexLocker locker(&shard.mutex);
+        purgeExpiredLocked(shard);
+        for (auto it = shard.partitions.constBegin(); it != shard.partitions.constEnd(); ++it) {
+            QPair<int, qint64>& totals = namespaces[it.key()];
+            totals.first += static_cast<int>(it->lru.size());
+            totals.second += it->bytes;
+        }
+        entries += shard.entries.size();
+        bytes += shard.totalBytes;
+        hits += shard.hits;
+        misses += shard.misses;
+        evictions += shard.evictions;
+        expirations += shard.expirations;
+    }
+
+    quint64 lookups = hits + misses;
+    QVariantMap result;
+    result["entries"] = entries;
+    result["bytes"] = bytes;
+    result["maxEntries"] = m_maxEntries.load();
+    result["maxBytes"] = m_maxBytes.load();
+    result["hits"] = hits;
+    result["misses"] = misses;
+    result["evictions"] = evictions;
+    result["expirations"] = expirations;
+    result["hitRate"] = lookups > 0 ? static_cast<double>(hits) / static_cast<double>(lookups) : 0.0;
+    result["shards"] = kShardCount;
+
+    QVariantMap namespaceStats;
+    for (auto it = namespaces.constBegin(); it != namespaces.constEnd(); ++it) {
+        QVariantMap item;
+        item["entries"] = it->first;
+        item["bytes"] = it->second;
+        item["budgetBytes"] = m_namespaceBudgets.value(it.key(), 0);
+        namespaceStats[it.key().isEmpty() ? QStringLiteral("(none)") : it.key()] = item;
+    }
+    result["namespaces"] = namespaceStats;
+
+    QMutexLocker locker(&m_diskMutex);
+    result["diskHits"] = m_diskHits;
+    result["pendingWrites"] = static_cast<int>(m_pendingWrites.size() + m_pendingRemovals.size()
+                                               + m_inFlightWrites.size() + m_inFlightRemovals.size());
+    return result;
 }
 
 QString CacheService::generateKey(const QString& service, const QString& endpoint, const QString& params)
@@ -139,63 +566,407 @@ QString CacheService::generateKeyFromQuery(const QString& service, const QString
     return generateKey(service, endpoint, params);
 }
 
-void CacheService::setCache(const QString& key, const QVariant& data, int ttlSeconds)
+void CacheService::setCache(const QString& key, const QVariant& data, int ttlSeconds, bool persist)
 {
-    auto service = ServiceRegistry::instance().resolve<CacheService>();
+    auto service = registered();
     if (service) {
-        service->set(key, data, ttlSeconds);
+        service->set(key, data, ttlSeconds, persist);
     }
 }
 
-void CacheService::setJsonCache(const QString& key, const QJsonObject& data, int ttlSeconds)
+void CacheService::setJsonCache(const QString& key, const QJsonObject& data, int ttlSeconds, bool persist)
 {
-    auto service = ServiceRegistry::instance().resolve<CacheService>();
+    auto service = registered();
     if (service) {
-        service->setJson(key, data, ttlSeconds);
+        service->setJson(key, data, ttlSeconds, persist);
     }
 }
 
-QVariant CacheService::getCache(const QString& key)
+QVariant CacheService::getCache(const QString& key, bool* fromDisk)
 {
-    auto service = ServiceRegistry::instance().resolve<CacheService>();
-    return service ? service->get(key) : QVariant();
+    auto service = registered();
+    if (!service) {
+        if (fromDisk) {
+            *fromDisk = false;
+        }
+        return QVariant();
+    }
+    return service->get(key, fromDisk);
 }
 
 QJsonObject CacheService::getJsonCache(const QString& key)
 {
-    auto service = ServiceRegistry::instance().resolve<CacheService>();
+    auto service = registered();
     return service ? service->getJson(key) : QJsonObject();
 }
 
 bool CacheService::hasCache(const QString& key)
 {
-    auto service = ServiceRegistry::instance().resolve<CacheService>();
+    auto service = registered();
     return service ? service->contains(key) : false;
 }
 
 void CacheService::removeCache(const QString& key)
 {
-    auto service = ServiceRegistry::instance().resolve<CacheService>();
+    auto service = registered();
     if (service) {
         service->remove(key);
     }
 }
 
-void CacheService::cleanupExpired() const
+void CacheService::eraseLocked(Shard& shard, QHash<QString, CacheEntry>::iterator it) const
 {
-    QList<QString> expiredKeys;
-    for (auto it = m_cache.begin(); it != m_cache.end(); ++it) {
-        if (it.value().isExpired()) {
-            expiredKeys.append(it.key());
+    // The heap item stays behind and is dropped when it reaches the top
+    shard.totalBytes -= it->sizeBytes;
+    shard.lru.erase(it->lruPosition);
+    auto partition = shard.partitions.find(it->ns);
+    if (partition != shard.partitions.end()) {
+        partition->lru.erase(it->nsLruPosition);
+        partition->bytes -= it->sizeBytes;
+        if (partition->lru.empty()) {
+            shard.partitions.erase(partition);
         }
     }
+    shard.entries.erase(it);
+}
 
-    for (const QString& key : expiredKeys) {
-        m_cache.remove(key);
+void CacheService::purgeExpiredLocked(Shard& shard) const
+{
+    // Only the entries that ran out are visited: O(k log n) for k expired entries
+    qint64 now = m_clock.elapsed();
+    while (!shard.expiryHeap.empty() && shard.expiryHeap.top().first <= now) {
+        const ExpiryItem& item = shard.expiryHeap.top();
+        auto it = shard.entries.find(item.second);
+        if (it != shard.entries.end() && it->expiresAtMs == item.first) {
+            eraseLocked(shard, it);
+            ++shard.expirations;
+        }
+        shard.expiryHeap.pop();
     }
+}
 
-    if (!expiredKeys.isEmpty()) {
-        LoggingService::logDebug("CacheService", QString("Cleaned up %1 expired cache entries").arg(expiredKeys.size()));
+void CacheService::evictOverCapacityLocked(Shard& shard, const QString& ns) const
+{
+    // A namespace over its budget gives up its own least recently used entries
+    qint64 budget = ns.isEmpty() ? 0 : m_namespaceBudgets.value(ns, 0);
+    if (budget > 0) {
+        qint64 shardBudget = qMax<qint64>(1, budget / kShardCount);
+        auto partition = shard.partitions.find(ns);
+        while (partition != shard.partitions.end() && partition->bytes > shardBudget && partition->lru.size() > 1) {
+            auto it = shard.entries.find(partition->lru.back());
+            if (it == shard.entries.end()) {
+                partition->lru.pop_back();
+                continue;
+            }
+            eraseLocked(shard, it);
+            ++shard.evictions;
+        }
     }
+
+    // Each shard holds an equal share of the limits
+    int maxEntries = m_maxEntries.load();
+    qint64 maxBytes = m_maxBytes.load();
+    qsizetype shardMaxEntries = maxEntries > 0 ? qMax(1, maxEntries / kShardCount) : 0;
+    qint64 shardMaxBytes = maxBytes > 0 ? qMax<qint64>(1, maxBytes / kShardCount) : 0;
+    auto overCapacity = [&shard, shardMaxEntries, shardMaxBytes]() {
+        return (shardMaxEntries > 0 && shard.entries.size() > shardMaxEntries)
+            || (shardMaxBytes > 0 && shard.totalBytes > shardMaxBytes);
+    };
+
+    // Never evict the entry that was just stored: it sits at the LRU front
+    while (overCapacity() && shard.lru.size() > 1) {
+        auto it = shard.entries.find(shard.lru.back());
+        if (it == shard.entries.end()) {
+            shard.lru.pop_back();
+            continue;
+        }
+        eraseLocked(shard, it);
+        ++shard.evictions;
+    }
+}
+
+void CacheService::compactExpiryHeapLocked(Shard& shard) const
+{
+    // Replaced and removed entries leave items behind; rebuild once they dominate
+    size_t live = static_cast<size_t>(shard.entries.size());
+    if (shard.expiryHeap.size() <= 2 * live + 64) {
+        return;
+    }
+
+    std::vector<ExpiryItem> items;
+    items.reserve(live);
+    for (auto it = shard.entries.constBegin(); it != shard.entries.constEnd(); ++it) {
+        items.emplace_back(it->expiresAtMs, it.key());
+    }
+    shard.expiryHeap = ExpiryHeap(std::greater<ExpiryItem>(), std::move(items));
+}
+
+bool CacheService::canUseDisk() const
+{
+    return QThread::currentThread() == thread() && m_dao->isAvailable();
 }
 
+bool CacheService::updatePersisted(const QString& key, const QVariant& data, int ttlSeconds, bool persist)
+{
+    {
+        QMutexLocker locker(&m_diskMutex);
+        if (persist) {
+            m_pendingRemovals.remove(key);
+            m_pendingWrites.insert(key, {data, QDateTime::currentMSecsSinceEpoch() + qMax(0, ttlSeconds) * 1000LL});
+        } else {
+            // A key that is no longer persisted must not come back from disk.
+            // Without the index (other thread, database not open) assume it may be there.
+            if (canUseDisk()) {
+                ensureDiskIndex();
+            }
+            bool pending = m_pendingWrites.remove(key);
+            bool inFlight = m_inFlightWrites.remove(key);
+            bool onDisk = pending || inFlight || m_diskKeys.contains(key) || !m_diskIndexLoaded;
+            if (!onDisk) {
+                return false;
+            }
+            m_pendingRemovals.insert(key);
+        }
+    }
+
+    scheduleFlush();
+    return true;
+}
+
+bool CacheService::loadPersisted(const QString& key, bool* fromDisk)
+{
+    qint64 now = QDateTime::currentMSecsSinceEpoch();
+    QVariant data;
+    qint64 expiresAt = 0;
+    {
+        QMutexLocker locker(&m_diskMutex);
+        auto pending = m_pendingWrites.constFind(key);
+        auto inFlight = m_inFlightWrites.constFind(key);
+        if (pending != m_pendingWrites.constEnd()) {
+            // Evicted from memory before it was written
+            data = pending->data;
+            expiresAt = pending->expiresAt;
+        } else if (m_pendingRemovals.contains(key) || m_inFlightRemovals.contains(key)) {
+            return false;
+        } else if (inFlight != m_inFlightWrites.constEnd()) {
+            // Evicted while the writer still has it
+            data = inFlight->data;
+            expiresAt = inFlight->expiresAt;
+        } else {
+            if (!canUseDisk()) {
+                return false;
+            }
+            ensureDiskIndex();
+            if (!m_diskKeys.contains(key)) {
+                return false;
+            }
+            CacheEntryRecord record = m_dao->getEntry(key);
+            QDataStream stream(record.payload);
+            stream.setVersion(QDataStream::Qt_6_0);
+            stream >> data;
+            if (!record.isValid() || stream.status() != QDataStream::Ok) {
+                m_diskKeys.remove(key);
+                return false;
+            }
+            expiresAt = record.expiresAt;
+            ++m_diskHits;
+            if (fromDisk) {
+                *fromDisk = true;
+            }
+        }
+
+        if (expiresAt <= now) {
+            m_diskKeys.remove(key);
+            return false;
+        }
+    }
+
+    Shard& shard = shardFor(key);
+    QMutexLocker locker(&shard.mutex);
+    if (!shard.entries.contains(key)) {
+        // Another thread may have stored a newer value meanwhile; that one wins
+        insertLocked(shard, key, data, expiresAt - now, data.typeId() == QMetaType::QJsonObject);
+    }
+    return true;
+}
+
+void CacheService::ensureDiskIndex()
+{
+    // Only keys are read up front; payloads are loaded on demand
+    if (m_diskIndexLoaded || !canUseDisk()) {
+        return;
+    }
+    m_diskIndexLoaded = true;
+
+    qint64 now = QDateTime::currentMSecsSinceEpoch();
+    if (!m_dao->removeExpired(now)) {
+        LoggingService::logWarning("CacheService", "Failed to prune expired persisted cache entries");
+    }
+    const QStringList keys = m_dao->getLiveKeys(now);
+    m_diskKeys = QSet<QString>(keys.begin(), keys.end());
+    for (const QString& prefix : std::as_const(m_pendingPrefixRemovals)) {
+        m_diskKeys.removeIf([&prefix](const QString& key) { return key.startsWith(prefix); });
+    }
+    LoggingService::logDebug("CacheService", QString("%1 persisted cache entries on disk").arg(m_diskKeys.size()));
+}
+
+void CacheService::scheduleFlush()
+{
+    if (QThread::currentThread() != thread()) {
+        QMetaObject::invokeMethod(this, &CacheService::scheduleFlush, Qt::QueuedConnection);
+        return;
+    }
+    if (!m_flushTimer->isActive()) {
+        m_flushTimer->start();
+    }
+}
+
+void CacheService::flushToDisk()
+{
+    m_flushTimer->stop();
+    dispatchBatch(false);
+}
+
+void CacheService::finishDiskWrites()
+{
+    m_flushTimer->stop();
+    dispatchBatch(true);
+}
+
+void CacheService::dispatchBatch(bool wait)
+{
+    DiskBatch batch;
+    {
+        QMutexLocker locker(&m_diskMutex);
+        if (m_pendingWrites.isEmpty() && m_pendingRemovals.isEmpty() && m_pendingPrefixRemovals.isEmpty()
+            && !m_diskClearPending) {
+            return;
+        }
+        if (!canUseDisk() || !m_diskThread->isRunning()) {
+            if (!wait) {
+                m_flushTimer->start(); // database not open yet
+            }
+            return;
+        }
+
+        // The index is read before the writer starts changing the table
+        ensureDiskIndex();
+
+        batch.id = ++m_lastBatch;
+        batch.clear = std::exchange(m_diskClearPending, false);
+        batch.prefixRemovals = std::exchange(m_pendingPrefixRemovals, QStringList());
+        batch.writes = std::exchange(m_pendingWrites, QHash<QString, PendingWrite>());
+        batch.removals = QStringList(m_pendingRemovals.begin(), m_pendingRemovals.end());
+        m_pendingRemovals.clear();
+
+        // Until the writer confirms, reads are answered from the batch
+        for (auto it = batch.writes.begin(); it != batch.writes.end(); ++it) {
+            it->batch = batch.id;
+            m_inFlightWrites.insert(it.key(), it.value());
+            m_inFlightRemovals.remove(it.key());
+        }
+        for (const QString& key : std::as_const(batch.removals)) {
+            m_inFlightRemovals.insert(key, batch.id);
+            m_inFlightWrites.remove(key);
+        }
+    }
+
+    QMetaObject::invokeMethod(m_diskWriter, [this, writer = m_diskWriter, batch]() {
+        DiskWriter::Result result = writer->write(batch);
+        QMetaObject::invokeMethod(this, [this, id = batch.id, result]() {
+            onBatchWritten(id, result.written, result.removed);
+        }, Qt::QueuedConnection);
+    }, wait ? Qt::BlockingQueuedConnection : Qt::QueuedConnection);
+}
+
+void CacheService::onBatchWritten(quint64 batch, const QStringList& written, const QStringList& removed)
+{
+    QMutexLocker locker(&m_diskMutex);
+    // Keys changed, invalidated or cleared since the batch left are no longer tracked under it
+    for (const QString& key : written) {
+        auto it = m_inFlightWrites.constFind(key);
+        if (it != m_inFlightWrites.constEnd() && it->batch == batch) {
+            m_diskKeys.insert(key);
+        }
+    }
+    for (const QString& key : removed) {
+        if (m_inFlightRemovals.value(key) == batch) {
+            m_diskKeys.remove(key);
+        }
+    }
+
+    // Entries the writer failed to commit are given up, as a failed flush always did
+    m_inFlightWrites.removeIf([batch](QHash<QString, PendingWrite>::iterator it) {
+        return it->batch == batch;
+    });
+    m_inFlightRemovals.removeIf([batch](QHash<QString, quint64>::iterator it) {
+        return it.value() == batch;
+    });
+}
+
+qint64 CacheService::approximateSize(const QVariant& value)
+{
+    // Rough payload estimate: string data plus a small per-node overhead
+    constexpr qint64 nodeOverhead = 16;
+    switch (value.typeId()) {
+    case QMetaType::QString:
+        return nodeOverhead + value.toString().size() * 2;
+    case QMetaType::QByteArray:
+        return nodeOverhead + value.toByteArray().size();
+    case QMetaType::QVariantList: {
+        qint64 total = nodeOverhead;
+        const QVariantList list = value.toList();
+        for (const QVariant& item : list) {
+            total += approximateSize(item);
+        }
+        return total;
+    }
+    case QMetaType::QVariantMap: {
+        qint64 total = nodeOverhead;
+        const QVariantMap map = value.toMap();
+        for (auto it = map.constBegin(); it != map.constEnd(); ++it) {
+            total += it.key().size() * 2 + approximateSize(it.value());
+        }
+        return total;
+    }
+    case QMetaType::QVariantHash: {
+        qint64 total = nodeOverhead;
+        const QVariantHash hash = value.toHash();
+        for (auto it = hash.constBegin(); it != hash.constEnd(); ++it) {
+            total += it.key().size() * 2 + approximateSize(it.value());
+        }
+        return total;
+    }
+    case QMetaType::QJsonObject:
+        return approximateJsonSize(QJsonValue(value.toJsonObject()));
+    case QMetaType::QJsonArray:
+        return approximateJsonSize(QJsonValue(value.toJsonArray()));
+    default:
+        return nodeOverhead;
+    }
+}
+
+qint64 CacheService::approximateJsonSize(const QJsonValue& value)
+{
+    constexpr qint64 nodeOverhead = 16;
+    if (value.isString()) {
+        return nodeOverhead + value.toString().size() * 2;
+    }
+    if (value.isObject()) {
+        qint64 total = nodeOverhead;
+        const QJsonObject object = value.toObject();
+        for (auto it = object.constBegin(); it != object.constEnd(); ++it) {
+            total += it.key().size() * 2 + approximateJsonSize(it.value());
+        }
+        return total;
+    }
+    if (value.isArray()) {
+        qint64 total = nodeOverhead;
+        const QJsonArray array = value.toArray();
+        for (const QJsonValue& item : array) {
+            total += approximateJsonSize(item);
+        }
+        return total;
+    }
+    return nodeOverhead;
+}
@@ -7,16 +7,57 @@
 #include <QVariantMap>
 #include <QJsonObject>
 #include <QJsonArray>
-#include <QDateTime>
-#include <QMap>
+#include <QJsonValue>
+#include <QHash>
+#include <QElapsedTimer>
+#include <QSet>
+#include <QStringList>
+#include <QMutex>
 #include <QUrlQuery>
 #include <QtQmlIntegration/qqmlintegration.h>
+#include <array>
+#include <atomic>
+#include <list>
+#include <memory>
+#include <queue>
+#include <utility>
+#include <vector>
+
+class CacheEntryDao;
+class QThread;
+class QTimer;
 
 /**
  * @brief Unified cache service for all data types
  * 
  * Provides consistent caching interface for QJsonObject, QVariantMap, and QVariantList
  * with TTL-based expiration and cache management.
+ *
+ * Entries live in a hash with an LRU list beside it, so a lookup costs O(1).
+ * Expiry times sit in a min-heap that is drained as far as it has run out,
+ * instead of scanning every entry on each read. The cache is bounded by entry
+ * count and by an estimate of the bytes held; the least recently used entries
+ * are evicted beyond either limit.
+ *
+ * The part of a key before the first ':' is its namespace ("metadata",
+ * "trakt", "streams", ...). Each namespace keeps its own LRU list, so it can
+ * be invalidated by visiting only its own entries, and may have a byte budget
+ * of its own: a namespace over budget evicts its own least recently used
+ * entries rather than those of its neighbours.
+ *
+ * Entries stored with persist set are also written to the cache_entries table,
+ * so they outlive an eviction and a restart. Writes are batched on a short
+ * timer and handed to a writer thread with a database connection of its own,
+ * so serialising and committing a batch never blocks the caller's thread. A
+ * memory miss on a key known to be on disk loads that one entry back; callers
+ * can ask whether a value came from disk and refresh it in the background.
+ *
+ * There is one cache, owned by the ServiceRegistry; instance() and the static
+ * helpers all reach it. It may be used from any thread. Keys are spread over
+ * kShardCount shards, each with its own lock, LRU list and share of the
+ * capacity, so concurrent readers rarely wait on each other. Disk reads only
+ * happen on the thread the cache lives in, where the database connection is;
+ * elsewhere a memory miss is a miss.
  */
 class CacheService : public QObject
 {
@@ -26,9 +67,13 @@ class CacheService : public QObject
 
 public:
     explicit CacheService(QObject* parent = nullptr);
+    ~CacheService() override;
 
     /**
-     * @brief Get singleton instance (for C++ usage)
+     * @brief The registry's cache (for C++ usage)
+     *
+     * CacheService must be registered with the ServiceRegistry before the
+     * first call; it is a fatal error otherwise.
      */
     static CacheService& instance();
 
@@ -37,35 +82,46 @@ public:
      * @param key Cache key
      * @param data Data to cache
      * @param ttlSeconds Time to live in seconds (default: 300 = 5 minutes)
+     * @param persist Also keep the entry on disk until it expires
      */
-    Q_INVOKABLE void set(const QString& key, const QVariant& data, int ttlSeconds = 300);
+    Q_INVOKABLE void set(const QString& key, const QVariant& data, int ttlSeconds = 300, bool persist = false);
 
     /**
      * @brief Store QJsonObject in cache
      * @param key Cache key
      * @param data JSON data to cache
      * @param ttlSeconds Time to live in seconds
+     * @param persist Also keep the entry on disk until it expires
+     */
+    Q_INVOKABLE void setJson(const QString& key, const QJsonObject& data, int ttlSeconds = 300, bool persist = false);
+
+    /**
+     * @brief Retrieve QVariant data from cache
+     * @param key Cache key
+     * @return Cached data or invalid QVariant if not found/expired
      */
-    Q_INVOKABLE void setJson(const QString& key, const QJsonObject& data, int ttlSeconds = 300);
+    Q_INVOKABLE QVariant get(const QString& key);
 
     /**
      * @brief Retrieve QVariant data from cache
      * @param key Cache key
+     * @param fromDisk Set to true when the value was loaded back from disk,
+     *        i.e. it may have been stored by an earlier run
      * @return Cached data or invalid QVariant if not found/expired
      */
-    Q_INVOKABLE QVariant get(const QString& key) const;
+    QVariant get(const QString& key, bool* fromDisk);
 
     /**
      * @brief Retrieve QJsonObject from cache
      * @param key Cache key
      * @return Cached JSON object or empty object if not found/expired
      */
-    Q_INVOKABLE QJsonObject getJson(const QString& key) const;
+    Q_INVOKABLE QJsonObject getJson(const QString& key);
 
     /**
      * @brief Check if key exists and is not expired
      */
-    Q_INVOKABLE bool contains(const QString& key) const;
+    Q_INVOKABLE bool contains(const QString& key);
 
     /**
      * @brief Remove specific key from cache
@@ -82,11 +138,51 @@ public:
      */
     Q_INVOKABLE void clearExpired();
 
+    /**
+     * @brief Remove every entry of a namespace, in memory and on disk
+     * @param ns Namespace, e.g. "metadata" for keys "metadata:..."
+     * @return Number of entries removed from memory
+     */
+    Q_INVOKABLE int invalidateNamespace(const QString& ns);
+
+    /**
+     * @brief Remove every entry whose key starts with prefix
+     *
+     * Only the entries of the prefix's namespace are visited.
+     * @return Number of entries removed from memory
+     */
+    Q_INVOKABLE int invalidatePrefix(const QString& prefix);
+
     /**
      * @brief Get current cache size (number of entries)
      */
     Q_INVOKABLE int size() const;
 
+    /**
+     * @brief Number of entries in one namespace
+     */
+    Q_INVOKABLE int namespaceSize(const QString& ns) const;
+
+    /**
+     * @brief Namespace of a key: the part before the first ':'
+     */
+    static QString namespaceOf(const QString& key);
+
+    /**
+     * @brief Limit the cache; 0 leaves a limit unbounded
+     *
+     * Entries beyond the new limits are evicted right away.
+     */
+    void setCapacity(int maxEntries, qint64 maxBytes);
+
+    /**
+     * @brief Cache counters since startup
+     * @return Map with entries, bytes, maxEntries, maxBytes, hits, misses,
+     *         diskHits, evictions, expirations, pendingWrites, hitRate and
+     *         namespaces (name -> entries, bytes, budgetBytes)
+     */
+    Q_INVOKABLE QVariantMap stats() const;
+
     /**
      * @brief Generate cache key from service, endpoint, and parameters
      * Format: service:endpoint:params
@@ -101,9 +197,9 @@ public:
     /**
      * @brief C++ convenience methods (public for service access)
      */
-    static void setCache(const QString& key, const QVariant& data, int ttlSeconds = 300);
-    static void setJsonCache(const QString& key, const QJsonObject& data, int ttlSeconds = 300);
-    static QVariant getCache(const QString& key);
+    static void setCache(const QString& key, const QVariant& data, int ttlSeconds = 300, bool persist = false);
+    static void setJsonCache(const QString& key, const QJsonObject& data, int ttlSeconds = 300, bool persist = false);
+    static QVariant getCache(const QString& key, bool* fromDisk = nullptr);
     static QJsonObject getJsonCache(const QString& key);
     static bool hasCache(const QString& key);
     static void removeCache(const QString& key);
@@ -120,22 +216,110 @@ signals:
     void cacheEntryRemoved(const QString& key);
 
 private:
+    using LruList = std::list<QString>;
+    using ExpiryItem = std::pair<qint64, QString>;  // expiry (ms on m_clock), key
+    using ExpiryHeap = std::priority_queue<ExpiryItem, std::vector<ExpiryItem>, std::greater<ExpiryItem>>;
+
     struct CacheEntry {
         QVariant data;
-        QDateTime timestamp;
-        int ttlSeconds;
-        bool isJson;
+        qint64 expiresAtMs = 0;
+        qint64 sizeBytes = 0;
+        bool isJson = false;
+        QString ns;
+        LruList::iterator lruPosition;  // most recently used at the front
+        LruList::iterator nsLruPosition;
+    };
+
+    // A namespace's entries within one shard
+    struct Partition {
+        LruList lru;
+        qint64 bytes = 0;
+    };
+
+    struct Shard {
+        QMutex mutex;
+        QHash<QString, CacheEntry> entries;
+        LruList lru;
+        QHash<QString, Partition> partitions;  // by namespace
+        // Lazily cleaned: an item whose entry was replaced or removed is skipped
+        ExpiryHeap expiryHeap;
+        qint64 totalBytes = 0;
+        quint64 hits = 0;
+        quint64 misses = 0;
+        quint64 evictions = 0;
+        quint64 expirations = 0;
+    };
 
-        CacheEntry() : ttlSeconds(300), isJson(false) {}
+    struct PendingWrite {
+        QVariant data;
+        qint64 expiresAt = 0;           // ms since epoch
+        quint64 batch = 0;              // batch carrying it, once handed to the writer
+    };
 
-        bool isExpired() const {
-            return QDateTime::currentDateTime().secsTo(timestamp) < -ttlSeconds;
-        }
+    // One flush, as handed to the writer thread
+    struct DiskBatch {
+        quint64 id = 0;
+        bool clear = false;
+        QStringList prefixRemovals;
+        QHash<QString, PendingWrite> writes;
+        QStringList removals;
     };
 
-    mutable QMap<QString, CacheEntry> m_cache;
+    class DiskWriter;
+
+    static std::shared_ptr<CacheService> registered();
+    Shard& shardFor(const QString& key) const;
+    // The *Locked helpers expect the shard's mutex to be held
+    void insertLocked(Shard& shard, const QString& key, const QVariant& data, qint64 ttlMs, bool isJson) const;
+    void eraseLocked(Shard& shard, QHash<QString, CacheEntry>::iterator it) const;
+    void purgeExpiredLocked(Shard& shard) const;
+    // Empty ns: only the shard-wide limits, no namespace budget
+    void evictOverCapacityLocked(Shard& shard, const QString& ns = QString()) const;
+    int invalidateLocked(Shard& shard, const QString& ns, const QString& prefix) const;
+    int invalidate(const QString& ns, const QString& prefix);
+    void compactExpiryHeapLocked(Shard& shard) const;
+    static qint64 approximateSize(const QVariant& value);
+    static qint64 approximateJsonSize(const QJsonValue& value);
+
+    bool updatePersisted(const QString& key, const QVariant& data, int ttlSeconds, bool persist);
+    bool loadPersisted(const QString& key, bool* fromDisk = nullptr);
+    bool canUseDisk() const;
+    void ensureDiskIndex();
+    void scheduleFlush();
+    void flushToDisk();
+    // Flush and wait until the writer thread has committed everything
+    void finishDiskWrites();
+    void dispatchBatch(bool wait);
+    void onBatchWritten(quint64 batch, const QStringList& written, const QStringList& removed);
+
+    static constexpr int kShardCount = 16;
+    static constexpr int kFlushDelayMs = 2000;
+
+    // Reads refresh LRU order and count hits, so shard state is mutable
+    mutable std::array<Shard, kShardCount> m_shards;
+    QElapsedTimer m_clock;
+    std::atomic<int> m_maxEntries;
+    std::atomic<qint64> m_maxBytes;
+    QHash<QString, qint64> m_namespaceBudgets;  // bytes; set once in the constructor
 
-    void cleanupExpired() const;
+    // Disk tier, guarded by m_diskMutex. Reads use the shared connection on
+    // thread(); writes go through m_diskWriter on m_diskThread.
+    mutable QMutex m_diskMutex;
+    std::unique_ptr<CacheEntryDao> m_dao;
+    QSet<QString> m_diskKeys;                   // live keys in cache_entries
+    bool m_diskIndexLoaded = false;
+    bool m_diskClearPending = false;
+    QHash<QString, PendingWrite> m_pendingWrites;
+    QSet<QString> m_pendingRemovals;
+    QStringList m_pendingPrefixRemovals;
+    // Handed to the writer, not yet confirmed; a newer batch for a key wins
+    QHash<QString, PendingWrite> m_inFlightWrites;
+    QHash<QString, quint64> m_inFlightRemovals;
+    quint64 m_lastBatch = 0;
+    quint64 m_diskHits = 0;
+    QTimer* m_flushTimer;
+    QThread* m_diskThread;
+    DiskWriter* m_diskWriter;           // lives on m_diskThread, deleted when it finishes
 };
 
 #endif // CACHE_SERVICE_H
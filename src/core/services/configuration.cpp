@@ -3,12 +3,29 @@
 #include <QStandardPaths>
 #include <QDir>
 #include <QFile>
+#include <QStringList>
 #include <QTextStream>
 
 Configuration::Configuration(QObject* parent)
     : QObject(parent)
     , m_tmdbBaseUrl("https://api.themoviedb.org/3")
     , m_tmdbImageBaseUrl("https://image.tmdb.org/t/p/")
+    , m_torrentReadAheadSeconds(30)
+    , m_torrentAssumedBitrate(2500000) // ~20 Mbit/s, a typical 1080p remux
+    , m_torrentStatusIntervalMs(1000)
+    , m_torrentWarmTopN(0) // magnets are only added to the session when played
+    , m_torrentCacheLimitBytes(10LL * 1024 * 1024 * 1024)
+    , m_torrentSessionProfile("streaming")
+    , m_torrentIdlePauseSeconds(60)
+    , m_torrentIdleRemoveMinutes(10)
+    , m_torrentMaxActive(3)
+    , m_streamAddonDeadlineMs(8000)
+    , m_streamCacheTtlSeconds(60)
+    , m_streamCacheStaleSeconds(30 * 60)
+    , m_streamPrefetchEnabled(false)
+    , m_streamPrefetchWarmTopN(1)
+    , m_cacheMaxEntries(5000)
+    , m_cacheMaxBytes(64LL * 1024 * 1024)
 {
     // Get API key from compile-time define
     QString apiKey = QString::fromUtf8(TMDB_API_KEY);
@@ -92,6 +109,122 @@ Configuration::Configuration(QObject* parent)
     } else {
         LoggingService::logDebug("Configuration", QString("Trakt API configured (client ID length: %1)").arg(m_traktClientId.length()));
     }
+    
+    // Torrent read-ahead window overrides
+    bool ok = false;
+    int readAheadSeconds = qEnvironmentVariableIntValue("YANTRIUM_TORRENT_READAHEAD_SECONDS", &ok);
+    if (ok && readAheadSeconds > 0) {
+        m_torrentReadAheadSeconds = readAheadSeconds;
+    }
+    qint64 assumedBitrate = QString::fromLocal8Bit(qgetenv("YANTRIUM_TORRENT_BITRATE")).toLongLong(&ok);
+    if (ok && assumedBitrate > 0) {
+        m_torrentAssumedBitrate = assumedBitrate;
+    }
+    int statusIntervalMs = qEnvironmentVariableIntValue("YANTRIUM_TORRENT_STATUS_INTERVAL_MS", &ok);
+    if (ok && statusIntervalMs > 0) {
+        m_torrentStatusIntervalMs = statusIntervalMs;
+    }
+    int warmTopN = qEnvironmentVariableIntValue("YANTRIUM_TORRENT_WARM_TOP_N", &ok);
+    if (ok && warmTopN >= 0) {
+        m_torrentWarmTopN = warmTopN;
+    }
+    
+    // Downloaded pieces and resume data persist here between sessions
+    m_torrentCacheDirectory = QString::fromLocal8Bit(qgetenv("YANTRIUM_TORRENT_CACHE_DIR"));
+    if (m_torrentCacheDirectory.isEmpty()) {
+        m_torrentCacheDirectory = QStandardPaths::writableLocation(QStandardPaths::CacheLocation)
+            + "/torrents";
+    }
+    // Torrent metadata is small and expensive to fetch, so it lives next to the
+    // database rather than in the evictable download cache
+    m_torrentMetadataDirectory = QString::fromLocal8Bit(qgetenv("YANTRIUM_TORRENT_METADATA_DIR"));
+    if (m_torrentMetadataDirectory.isEmpty()) {
+        m_torrentMetadataDirectory = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation)
+            + "/torrent-metadata";
+    }
+    qint64 cacheLimitMb = QString::fromLocal8Bit(qgetenv("YANTRIUM_TORRENT_CACHE_MB")).toLongLong(&ok);
+    if (ok && cacheLimitMb > 0) {
+        m_torrentCacheLimitBytes = cacheLimitMb * 1024 * 1024;
+    }
+    // libtorrent session profile: streaming, balanced or low-resource; the
+    // environment wins over the one saved from the settings screen
+    QString sessionProfile = QString::fromLocal8Bit(qgetenv("YANTRIUM_TORRENT_PROFILE")).trimmed().toLower();
+    if (sessionProfile.isEmpty()) {
+        QFile profileFile(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/torrent_profile.txt");
+        if (profileFile.open(QIODevice::ReadOnly | QIODevice::Text)) {
+            QTextStream in(&profileFile);
+            sessionProfile = in.readLine().trimmed().toLower();
+        }
+    }
+    if (isTorrentSessionProfile(sessionProfile)) {
+        m_torrentSessionProfile = sessionProfile;
+    } else if (!sessionProfile.isEmpty()) {
+        LoggingService::logWarning("Configuration",
+            QString("Unknown torrent session profile %1, using %2").arg(sessionProfile, m_torrentSessionProfile));
+    }
+    // Idle teardown of torrents without a reader (0 disables each step)
+    int idlePauseSeconds = qEnvironmentVariableIntValue("YANTRIUM_TORRENT_IDLE_PAUSE_SECONDS", &ok);
+    if (ok && idlePauseSeconds >= 0) {
+        m_torrentIdlePauseSeconds = idlePauseSeconds;
+    }
+    int idleRemoveMinutes = qEnvironmentVariableIntValue("YANTRIUM_TORRENT_IDLE_REMOVE_MINUTES", &ok);
+    if (ok && idleRemoveMinutes >= 0) {
+        m_torrentIdleRemoveMinutes = idleRemoveMinutes;
+    }
+    int maxActive = qEnvironmentVariableIntValue("YANTRIUM_TORRENT_MAX_ACTIVE", &ok);
+    if (ok && maxActive >= 0) {
+        m_torrentMaxActive = maxActive;
+    }
+    
+    // Stream lists are finalised after this even if some addon has not answered
+    int addonDeadlineMs = qEnvironmentVariableIntValue("YANTRIUM_STREAM_ADDON_DEADLINE_MS", &ok);
+    if (ok && addonDeadlineMs > 0) {
+        m_streamAddonDeadlineMs = addonDeadlineMs;
+    }
+    
+    // Cached stream lists are served without asking the addon for the TTL, and
+    // served while being refreshed until they are stale
+    int cacheTtl = qEnvironmentVariableIntValue("YANTRIUM_STREAM_CACHE_TTL_SECONDS", &ok);
+    if (ok && cacheTtl >= 0) {
+        m_streamCacheTtlSeconds = cacheTtl;
+    }
+    int cacheStale = qEnvironmentVariableIntValue("YANTRIUM_STREAM_CACHE_STALE_SECONDS", &ok);
+    if (ok && cacheStale >= 0) {
+        m_streamCacheStaleSeconds = cacheStale;
+    }
+    
+    // Opt-in: resolve streams of the next episode while its card or detail page
+    // is in view, and warm the best torrent(s) among them
+    m_streamPrefetchEnabled = qEnvironmentVariableIntValue("YANTRIUM_STREAM_PREFETCH") > 0;
+    int prefetchWarmTopN = qEnvironmentVariableIntValue("YANTRIUM_STREAM_PREFETCH_WARM_TOP_N", &ok);
+    if (ok && prefetchWarmTopN >= 0) {
+        m_streamPrefetchWarmTopN = prefetchWarmTopN;
+    }
+    
+    // CacheService evicts least recently used entries beyond either limit (0 = unbounded)
+    int cacheMaxEntries = qEnvironmentVariableIntValue("YANTRIUM_CACHE_MAX_ENTRIES", &ok);
+    if (ok && cacheMaxEntries >= 0) {
+        m_cacheMaxEntries = cacheMaxEntries;
+    }
+    qint64 cacheMaxMb = QString::fromLocal8Bit(qgetenv("YANTRIUM_CACHE_MAX_MB")).toLongLong(&ok);
+    if (ok && cacheMaxMb >= 0) {
+        m_cacheMaxBytes = cacheMaxMb * 1024 * 1024;
+    }
+    
+    // Byte budget per key namespace, so one busy namespace cannot push the
+    // others out. Override as "metadata=32,trakt=16,streams=8" (MB, 0 = none).
+    m_cacheNamespaceBudgets.insert("metadata", 32LL * 1024 * 1024);
+    m_cacheNamespaceBudgets.insert("trakt", 16LL * 1024 * 1024);
+    m_cacheNamespaceBudgets.insert("streams", 8LL * 1024 * 1024);
+    const QStringList budgets = QString::fromLocal8Bit(qgetenv("YANTRIUM_CACHE_BUDGETS"))
+        .split(',', Qt::SkipEmptyParts);
+    for (const QString& budget : budgets) {
+        QString ns = budget.section('=', 0, 0).trimmed();
+        qint64 budgetMb = budget.section('=', 1, 1).trimmed().toLongLong(&ok);
+        if (!ns.isEmpty() && ok && budgetMb >= 0) {
+            m_cacheNamespaceBudgets.insert(ns, budgetMb * 1024 * 1024);
+        }
+    }
 }
 
 Configuration::~Configuration()
@@ -227,3 +360,133 @@ bool Configuration::isTraktConfigured() const
     return !m_traktClientId.isEmpty() && !m_traktClientSecret.isEmpty();
 }
 
+int Configuration::torrentReadAheadSeconds() const
+{
+    return m_torrentReadAheadSeconds;
+}
+
+qint64 Configuration::torrentAssumedBitrate() const
+{
+    return m_torrentAssumedBitrate;
+}
+
+int Configuration::torrentStatusIntervalMs() const
+{
+    return m_torrentStatusIntervalMs;
+}
+
+int Configuration::torrentWarmTopN() const
+{
+    return m_torrentWarmTopN;
+}
+
+QString Configuration::torrentCacheDirectory() const
+{
+    return m_torrentCacheDirectory;
+}
+
+QString Configuration::torrentMetadataDirectory() const
+{
+    return m_torrentMetadataDirectory;
+}
+
+qint64 Configuration::torrentCacheLimitBytes() const
+{
+    return m_torrentCacheLimitBytes;
+}
+
+QString Configuration::torrentSessionProfile() const
+{
+    return m_torrentSessionProfile;
+}
+
+bool Configuration::isTorrentSessionProfile(const QString& profile)
+{
+    // Profiles TorrentStreamServer::setSessionProfile knows
+    return profile == "streaming" || profile == "balanced" || profile == "low-resource";
+}
+
+bool Configuration::saveTorrentSessionProfile(const QString& profile)
+{
+    QString normalized = profile.trimmed().toLower();
+    if (!isTorrentSessionProfile(normalized)) {
+        LoggingService::logWarning("Configuration", QString("Unknown torrent session profile: %1").arg(profile));
+        return false;
+    }
+    QString dataDir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+    if (!QDir().mkpath(dataDir)) {
+        LoggingService::logError("Configuration", QString("Failed to create data directory: %1").arg(dataDir));
+        return false;
+    }
+    
+    QFile file(dataDir + "/torrent_profile.txt");
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        LoggingService::logError("Configuration", QString("Failed to open config file for writing: %1").arg(file.fileName()));
+        return false;
+    }
+    QTextStream out(&file);
+    out << normalized;
+    file.close();
+    
+    if (m_torrentSessionProfile != normalized) {
+        m_torrentSessionProfile = normalized;
+        emit torrentSessionProfileChanged();
+    }
+    LoggingService::logDebug("Configuration", QString("Torrent session profile saved: %1").arg(normalized));
+    return true;
+}
+
+int Configuration::torrentIdlePauseSeconds() const
+{
+    return m_torrentIdlePauseSeconds;
+}
+
+int Configuration::torrentIdleRemoveMinutes() const
+{
+    return m_torrentIdleRemoveMinutes;
+}
+
+int Configuration::torrentMaxActive() const
+{
+    return m_torrentMaxActive;
+}
+
+int Configuration::streamAddonDeadlineMs() const
+{
+    return m_streamAddonDeadlineMs;
+}
+
+int Configuration::streamCacheTtlSeconds() const
+{
+    return m_streamCacheTtlSeconds;
+}
+
+int Configuration::streamCacheStaleSeconds() const
+{
+    return m_streamCacheStaleSeconds;
+}
+
+bool Configuration::streamPrefetchEnabled() const
+{
+    return m_streamPrefetchEnabled;
+}
+
+int Configuration::streamPrefetchWarmTopN() const
+{
+    return m_streamPrefetchWarmTopN;
+}
+
+int Configuration::cacheMaxEntries() const
+{
+    return m_cacheMaxEntries;
+}
+
+qint64 Configuration::cacheMaxBytes() const
+{
+    return m_cacheMaxBytes;
+}
+
+QHash<QString, qint64> Configuration::cacheNamespaceBudgets() const
+{
+    return m_cacheNamespaceBudgets;
+}
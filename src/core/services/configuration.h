@@ -3,6 +3,7 @@
 
 #include <QObject>
 #include <QString>
+#include <QHash>
 #include <QtQmlIntegration/qqmlintegration.h>
 
 // Compile-time API key definitions
@@ -30,6 +31,7 @@ class Configuration : public QObject
     Q_PROPERTY(QString tmdbBaseUrl READ tmdbBaseUrl CONSTANT)
     Q_PROPERTY(QString tmdbImageBaseUrl READ tmdbImageBaseUrl CONSTANT)
     Q_PROPERTY(QString omdbApiKey READ omdbApiKey NOTIFY omdbApiKeyChanged)
+    Q_PROPERTY(QString torrentSessionProfile READ torrentSessionProfile NOTIFY torrentSessionProfileChanged)
 
 public:
     explicit Configuration(QObject* parent = nullptr);
@@ -54,13 +56,48 @@ public:
     QString traktApiVersion() const;
     int defaultTraktCompletionThreshold() const;
     bool isTraktConfigured() const;
+    
+    // Torrent streaming configuration
+    int torrentReadAheadSeconds() const;
+    qint64 torrentAssumedBitrate() const;
+    int torrentStatusIntervalMs() const;
+    int torrentWarmTopN() const;
+    QString torrentCacheDirectory() const;
+    QString torrentMetadataDirectory() const;
+    qint64 torrentCacheLimitBytes() const;
+    QString torrentSessionProfile() const;
+    /**
+     * @brief Remember the torrent session profile chosen in the settings
+     *
+     * Applies right away and in later sessions; YANTRIUM_TORRENT_PROFILE still
+     * takes precedence at startup.
+     */
+    Q_INVOKABLE bool saveTorrentSessionProfile(const QString& profile);
+    int torrentIdlePauseSeconds() const;
+    int torrentIdleRemoveMinutes() const;
+    int torrentMaxActive() const;
+    
+    // Stream discovery configuration
+    int streamAddonDeadlineMs() const;
+    int streamCacheTtlSeconds() const;
+    int streamCacheStaleSeconds() const;
+    bool streamPrefetchEnabled() const;
+    int streamPrefetchWarmTopN() const;
+    
+    // In-memory cache configuration
+    int cacheMaxEntries() const;
+    qint64 cacheMaxBytes() const;
+    QHash<QString, qint64> cacheNamespaceBudgets() const;
 
 signals:
     void omdbApiKeyChanged();
+    void torrentSessionProfileChanged();
 
 private:
     Q_DISABLE_COPY(Configuration)
 
+    static bool isTorrentSessionProfile(const QString& profile);
+
     QString m_tmdbApiKey;
     QString m_tmdbBaseUrl;
     QString m_tmdbImageBaseUrl;
@@ -69,6 +106,31 @@ private:
     // Trakt configuration
     QString m_traktClientId;
     QString m_traktClientSecret;
+    
+    // Torrent streaming configuration
+    int m_torrentReadAheadSeconds;
+    qint64 m_torrentAssumedBitrate;
+    int m_torrentStatusIntervalMs;
+    int m_torrentWarmTopN;
+    QString m_torrentCacheDirectory;
+    QString m_torrentMetadataDirectory;
+    qint64 m_torrentCacheLimitBytes;
+    QString m_torrentSessionProfile;
+    int m_torrentIdlePauseSeconds;
+    int m_torrentIdleRemoveMinutes;
+    int m_torrentMaxActive;
+    
+    // Stream discovery configuration
+    int m_streamAddonDeadlineMs;
+    int m_streamCacheTtlSeconds;
+    int m_streamCacheStaleSeconds;
+    bool m_streamPrefetchEnabled;
+    int m_streamPrefetchWarmTopN;
+    
+    // In-memory cache configuration
+    int m_cacheMaxEntries;
+    qint64 m_cacheMaxBytes;
+    QHash<QString, qint64> m_cacheNamespaceBudgets;    // bytes per key namespace
 };
 
 #endif // CONFIGURATION_H
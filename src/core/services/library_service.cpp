@@ -6,6 +6,9 @@
 #include "core/services/configuration.h"
 #include "core/services/frontend_data_mapper.h"
 #include "core/services/local_library_service.h"
+#include "core/services/addon_health_service.h"
+#include "core/services/navigation_service.h"
+#include "core/di/service_registry.h"
 #include "features/addons/logic/addon_client.h"
 #include "features/addons/models/addon_config.h"
 #include "features/addons/models/addon_manifest.h"
@@ -56,6 +59,11 @@ LibraryService::LibraryService(
         connect(m_localLibraryService.get(), &LocalLibraryService::watchProgressLoaded,
                 this, &LibraryService::onWatchProgressLoaded);
     }
+    
+    // Leaving the detail screen abandons its metadata request
+    if (auto navigation = ServiceRegistry::instance().resolve<NavigationService>()) {
+        connect(navigation.get(), &NavigationService::backRequested, this, &LibraryService::cancelItemDetails);
+    }
 }
 
 void LibraryService::loadCatalogs()
@@ -134,13 +142,14 @@ void LibraryService::loadCatalogsRaw(bool rawMode)
                 continue;
             }
             
-            enabledCatalogCount++;
-            m_pendingCatalogRequests++;
-            
             // Create a NEW AddonClient for each catalog request
             // This is necessary because AddonClient only supports one concurrent request
-            AddonClient* client = new AddonClient(baseUrl, this);
-            m_activeClients.append(client);
+            AddonClient* client = createAddonClient(addon, "catalog");
+            if (!client) {
+                continue;
+            }
+            enabledCatalogCount++;
+            m_pendingCatalogRequests++;
             
             // Store addon ID and catalog info on client for this specific request
             client->setProperty("addonId", addon.id);
@@ -166,6 +175,24 @@ void LibraryService::loadCatalogsRaw(bool rawMode)
     }
 }
 
+AddonClient* LibraryService::createAddonClient(const AddonConfig& addon, const QString& resource)
+{
+    auto health = ServiceRegistry::instance().resolve<AddonHealthService>();
+    if (health && !health->allowRequest(addon.id, resource)) {
+        LoggingService::logDebug("LibraryService",
+            QString("Skipping failing addon %1 (%2)").arg(addon.name, resource));
+        return nullptr;
+    }
+
+    AddonClient* client = new AddonClient(AddonClient::extractBaseUrl(addon.manifestUrl), this);
+    client->setAddonId(addon.id);
+    if (health) {
+        client->setTimeout(health->timeoutFor(addon.id, resource));
+    }
+    m_activeClients.append(client);
+    return client;
+}
+
 void LibraryService::loadCatalog(const QString& addonId, const QString& type, const QString& id)
 {
     AddonConfig addon = m_addonRepository->getAddon(addonId);
@@ -176,9 +203,11 @@ void LibraryService::loadCatalog(const QString& addonId, const QString& type, co
         return;
     }
 
-    QString baseUrl = AddonClient::extractBaseUrl(addon.manifestUrl);
-    AddonClient* client = new AddonClient(baseUrl, this);
-    m_activeClients.append(client);
+    AddonClient* client = createAddonClient(addon, "catalog");
+    if (!client) {
+        emit error(QString("Addon %1 is not responding").arg(addon.name));
+        return;
+    }
     
     connect(client, &AddonClient::catalogFetched, this, &LibraryService::onCatalogFetched);
     connect(client, &AddonClient::error, this, &LibraryService::onClientError);
@@ -219,8 +248,10 @@ void LibraryService::loadHeroItems()
             }
 
             QString baseUrl = AddonClient::extractBaseUrl(addon.manifestUrl);
-            AddonClient* client = new AddonClient(baseUrl, this);
-            m_activeClients.append(client);
+            AddonClient* client = createAddonClient(addon, "catalog");
+            if (!client) {
+                continue;
+            }
             m_pendingHeroRequests++;
             
             // Store hero catalog info on client
@@ -337,11 +368,12 @@ void LibraryService::searchCatalogs(const QString& query)
             continue;
         }
         
-        m_pendingSearchRequests++;
-        
         // Create a new AddonClient for each search request
-        AddonClient* client = new AddonClient(info.baseUrl, this);
-        m_activeClients.append(client);
+        AddonClient* client = createAddonClient(info.addon, "search");
+        if (!client) {
+            continue;
+        }
+        m_pendingSearchRequests++;
         
         // Store search info on client
         client->setProperty("isSearchRequest", true);
@@ -1094,6 +1126,11 @@ void LibraryService::loadItemDetails(const QString& contentId, const QString& ty
         return;
     }
     
+    // A newer item replaces the one still loading
+    if (contentId != m_pendingDetailsContentId || type != m_pendingDetailsType) {
+        cancelItemDetails();
+    }
+    
     // Store request info
     m_pendingDetailsContentId = contentId;
     m_pendingDetailsType = type;
@@ -1103,6 +1140,23 @@ void LibraryService::loadItemDetails(const QString& contentId, const QString& ty
     m_mediaMetadataService->getCompleteMetadata(contentId, type);
 }
 
+void LibraryService::cancelItemDetails()
+{
+    if (m_pendingDetailsContentId.isEmpty()) {
+        return;
+    }
+    // Continue watching enrichment may be waiting on the same item
+    if (m_mediaMetadataService && !m_pendingContinueWatchingItems.contains(m_pendingDetailsContentId)
+        && !m_pendingSeasonEpisodesRequests.contains(m_pendingDetailsContentId)) {
+        LoggingService::logDebug("LibraryService",
+            QString("Cancelling details request for %1").arg(m_pendingDetailsContentId));
+        m_mediaMetadataService->cancelRequest(m_pendingDetailsContentId, m_pendingDetailsType);
+    }
+    m_pendingDetailsContentId.clear();
+    m_pendingDetailsType.clear();
+    m_pendingDetailsAddonId.clear();
+}
+
 void LibraryService::onMediaMetadataLoaded(const QVariantMap& details)
 {
     LoggingService::logDebug("LibraryService", "Complete metadata loaded from MediaMetadataService");
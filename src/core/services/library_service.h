@@ -96,8 +96,13 @@ private:
     };
     
     void processCatalogData(const QString& addonId, const QString& catalogName, const QString& type, const QJsonArray& metas);
+    /**
+     * @brief New tracked client for addon, or nullptr while its circuit breaker is open
+     */
+    AddonClient* createAddonClient(const AddonConfig& addon, const QString& resource);
     QVariantMap traktPlaybackItemToVariantMap(const QVariantMap& traktItem);
     void finishLoadingCatalogs();
+    void cancelItemDetails();
     
     std::shared_ptr<AddonRepository> m_addonRepository;
     TraktCoreService* m_traktService;
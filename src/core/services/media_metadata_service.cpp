@@ -8,6 +8,7 @@
 #include "frontend_data_mapper.h"
 #include "id_parser.h"
 #include "configuration.h"
+#include "addon_health_service.h"
 #include "features/addons/logic/addon_repository.h"
 #include "features/addons/logic/addon_client.h"
 #include "features/addons/models/addon_config.h"
@@ -50,7 +51,8 @@ void MediaMetadataService::getCompleteMetadata(const QString& contentId, const Q
     
     // Check cache first
     QString cacheKey = "metadata:" + contentId + "|" + type;
-    QVariant cached = CacheService::instance().get(cacheKey);
+    bool fromDisk = false;
+    QVariant cached = CacheService::instance().get(cacheKey, &fromDisk);
     if (cached.isValid() && cached.canConvert<QVariantMap>()) {
         LoggingService::logDebug("MediaMetadataService", QString("Cache hit for: %1").arg(cacheKey));
         QVariantMap cachedDetails = cached.toMap();
@@ -64,6 +66,14 @@ void MediaMetadataService::getCompleteMetadata(const QString& contentId, const Q
         }
         
         emit metadataLoaded(cachedDetails);
+
+        // A copy persisted by an earlier run is shown while a fresh one loads behind it
+        if (fromDisk && m_addonRepository && !m_pendingDetailsByContentId.contains(contentId + "|" + type)) {
+            AddonConfig metadataAddon = findMetadataAddon();
+            if (!metadataAddon.id.isEmpty()) {
+                fetchMetadataFromAddon(metadataAddon, contentId, type, true);
+            }
+        }
         return;
     }
     
@@ -81,6 +91,21 @@ void MediaMetadataService::getCompleteMetadata(const QString& contentId, const Q
     emit error("No metadata addon available");
 }
 
+void MediaMetadataService::cancelRequest(const QString& contentId, const QString& type)
+{
+    QString cacheKey = contentId + "|" + type;
+    for (auto it = m_pendingAddonRequests.begin(); it != m_pendingAddonRequests.end();) {
+        if (it.value() == cacheKey) {
+            it.key()->abort();
+            it.key()->deleteLater();
+            it = m_pendingAddonRequests.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    m_pendingDetailsByContentId.remove(cacheKey);
+}
+
 void MediaMetadataService::onOmdbRatingsFetched(const QString& imdbId, const QJsonObject& data)
 {
     if (!m_pendingDetailsByContentId.contains(imdbId)) {
@@ -97,7 +122,7 @@ void MediaMetadataService::onOmdbRatingsFetched(const QString& imdbId, const QJs
     
     // Cache and emit complete metadata
     QString cacheKey = "metadata:" + request.contentId + "|" + request.type;
-    CacheService::instance().set(cacheKey, QVariant::fromValue(details), 3600); // 1 hour TTL
+    CacheService::instance().set(cacheKey, QVariant::fromValue(details), 3600, true); // 1 hour TTL, kept across restarts
     
     emit metadataLoaded(details);
     
@@ -113,7 +138,7 @@ void MediaMetadataService::onOmdbError(const QString& /*message*/, const QString
         
         // Cache and emit metadata
         QString cacheKey = "metadata:" + request.contentId + "|" + request.type;
-        CacheService::instance().set(cacheKey, QVariant::fromValue(request.details), 3600); // 1 hour TTL
+        CacheService::instance().set(cacheKey, QVariant::fromValue(request.details), 3600, true); // 1 hour TTL, kept across restarts
         
         emit metadataLoaded(request.details);
         m_pendingDetailsByContentId.remove(imdbId);
@@ -122,17 +147,14 @@ void MediaMetadataService::onOmdbError(const QString& /*message*/, const QString
 
 void MediaMetadataService::clearMetadataCache()
 {
-    // Clear metadata cache entries (all entries with "metadata:" prefix)
-    // Note: CacheService doesn't support prefix-based clearing yet
-    // For now, we'll clear all cache (can be optimized later)
-    CacheService::instance().clear();
+    // Only the "metadata:" entries; Trakt and stream data stay warm
+    CacheService::instance().invalidateNamespace("metadata");
     LoggingService::logInfo("MediaMetadataService", "Metadata cache cleared");
 }
 
 int MediaMetadataService::getMetadataCacheSize() const
 {
-    auto cacheService = ServiceRegistry::instance().resolve<CacheService>();
-    return cacheService ? cacheService->size() : 0;
+    return CacheService::instance().namespaceSize("metadata");
 }
 
 QVariantList MediaMetadataService::getSeriesEpisodes(const QString& contentId, int seasonNumber)
@@ -182,8 +204,8 @@ AddonConfig MediaMetadataService::findMetadataAddon()
     }
     
     QList<AddonConfig> enabledAddons = m_addonRepository->getEnabledAddons();
-    AddonConfig aiometadataAddon;  // Prefer AIOMetadata if available
-    AddonConfig fallbackAddon;     // Fall back to any addon with meta resource
+    QList<AddonConfig> candidates;  // AIOMetadata first, then other addons with meta resource
+    qsizetype preferredCount = 0;
     
     for (const AddonConfig& addon : enabledAddons) {
         AddonManifest manifest = m_addonRepository->getManifest(addon);
@@ -197,19 +219,25 @@ AddonConfig MediaMetadataService::findMetadataAddon()
         QString idLower = addon.id.toLower();
         QString nameLower = addon.name.toLower();
         if (idLower.contains("aiometadata") || nameLower.contains("aiometadata")) {
-            aiometadataAddon = addon;
-            break;  // Found AIOMetadata, prefer it
-        } else if (fallbackAddon.id.isEmpty()) {
-            // Store first addon with meta resource as fallback
-            fallbackAddon = addon;
+            candidates.insert(preferredCount++, addon);
+        } else {
+            candidates.append(addon);
         }
     }
     
-    // Return AIOMetadata if available, otherwise fallback to any metadata addon
-    return !aiometadataAddon.id.isEmpty() ? aiometadataAddon : fallbackAddon;
+    // Take the preferred addon unless it is failing right now
+    auto health = ServiceRegistry::instance().resolve<AddonHealthService>();
+    for (const AddonConfig& addon : std::as_const(candidates)) {
+        if (!health || health->allowRequest(addon.id, "meta")) {
+            return addon;
+        }
+        LoggingService::logDebug("MediaMetadataService", QString("Skipping failing metadata addon %1").arg(addon.name));
+    }
+    return AddonConfig();
 }
 
-void MediaMetadataService::fetchMetadataFromAddon(const AddonConfig& addon, const QString& contentId, const QString& type)
+void MediaMetadataService::fetchMetadataFromAddon(const AddonConfig& addon, const QString& contentId, const QString& type,
+                                                  bool revalidate)
 {
     if (addon.id.isEmpty()) {
         LoggingService::report("Metadata addon not found", "ADDON_ERROR", "MediaMetadataService");
@@ -219,6 +247,10 @@ void MediaMetadataService::fetchMetadataFromAddon(const AddonConfig& addon, cons
     
     QString baseUrl = AddonClient::extractBaseUrl(addon.manifestUrl);
     AddonClient* client = new AddonClient(baseUrl, this);
+    client->setAddonId(addon.id);
+    if (auto health = ServiceRegistry::instance().resolve<AddonHealthService>()) {
+        client->setTimeout(health->timeoutFor(addon.id, "meta"));
+    }
     
     // Store cache key for this request
     QString cacheKey = contentId + "|" + type;
@@ -228,6 +260,7 @@ void MediaMetadataService::fetchMetadataFromAddon(const AddonConfig& addon, cons
     PendingRequest request;
     request.contentId = contentId;
     request.type = type;
+    request.revalidating = revalidate;
     m_pendingDetailsByContentId[cacheKey] = request;
     
     // Connect signals
@@ -284,8 +317,13 @@ void MediaMetadataService::onAddonMetaFetched(const QString& type, const QString
     QVariantMap details = FrontendDataMapper::mapAddonMetaToDetailVariantMap(meta, request.contentId, normalizedType);
     
     if (details.isEmpty()) {
-        LoggingService::report("Failed to convert addon metadata to detail map", "CONVERSION_ERROR", "MediaMetadataService");
-        emit error("Failed to convert addon metadata to detail map");
+        if (request.revalidating) {
+            LoggingService::logWarning("MediaMetadataService", "Failed to convert refreshed addon metadata to detail map");
+        } else {
+            LoggingService::report("Failed to convert addon metadata to detail map", "CONVERSION_ERROR", "MediaMetadataService");
+            emit error("Failed to convert addon metadata to detail map");
+        }
+        m_pendingDetailsByContentId.remove(cacheKey);
         if (m_pendingAddonRequests.contains(client)) {
             m_pendingAddonRequests.remove(client);
         }
@@ -477,7 +515,7 @@ void MediaMetadataService::onAddonMetaFetched(const QString& type, const QString
     
     // Cache and emit metadata
     QString cacheKeyForCache = "metadata:" + request.contentId + "|" + normalizedType;
-    CacheService::instance().set(cacheKeyForCache, QVariant::fromValue(details), 3600); // 1 hour TTL
+    CacheService::instance().set(cacheKeyForCache, QVariant::fromValue(details), 3600, true); // 1 hour TTL, kept across restarts
     
     emit metadataLoaded(details);
     
@@ -504,11 +542,18 @@ void MediaMetadataService::onAddonMetaError(const QString& errorMessage)
     }
     
     QString cacheKey = m_pendingAddonRequests.take(client);
+    bool revalidating = false;
     if (!cacheKey.isEmpty()) {
-        m_pendingDetailsByContentId.remove(cacheKey);
+        revalidating = m_pendingDetailsByContentId.take(cacheKey).revalidating;
     }
     
     QString errorMsg = QString("Failed to fetch metadata from addon: %1").arg(errorMessage);
+    if (revalidating) {
+        // The persisted copy is already on screen; keep it
+        LoggingService::logWarning("MediaMetadataService", errorMsg);
+        client->deleteLater();
+        return;
+    }
     LoggingService::report(errorMsg, "ADDON_ERROR", "MediaMetadataService");
     emit error(errorMsg);
     
@@ -31,6 +31,11 @@ public:
     Q_INVOKABLE void getCompleteMetadata(const QString& contentId, const QString& type);
     void getCompleteMetadataFromTmdbId(int tmdbId, const QString& type) override;
     
+    /**
+     * @brief Abort an in-flight getCompleteMetadata request; metadataLoaded is not emitted for it
+     */
+    void cancelRequest(const QString& contentId, const QString& type);
+    
     // Get episodes for a series (from cached AIOMetadata response)
     Q_INVOKABLE QVariantList getSeriesEpisodes(const QString& contentId, int seasonNumber = -1);
     
@@ -58,6 +63,7 @@ private:
         QString contentId;
         QString type;
         QVariantMap details;
+        bool revalidating = false;  // refreshes a persisted copy already shown; failures stay quiet
     };
     
     QMap<QString, PendingRequest> m_pendingDetailsByContentId; // contentId -> pending request
@@ -66,7 +72,8 @@ private:
     
     // Helper methods
     AddonConfig findMetadataAddon();  // Prefers AIOMetadata, falls back to any addon with meta resource
-    void fetchMetadataFromAddon(const AddonConfig& addon, const QString& contentId, const QString& type);
+    void fetchMetadataFromAddon(const AddonConfig& addon, const QString& contentId, const QString& type,
+                                bool revalidate = false);
 };
 
 #endif // MEDIA_METADATA_SERVICE_H
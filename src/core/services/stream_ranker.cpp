@@ -0,0 +1,298 @@
+#include "stream_ranker.h"
+#include <QRegularExpression>
+#include <QSet>
+#include <QUrl>
+#include <QUrlQuery>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace {
+// Compiled once per process; ranking never builds a pattern per stream
+const QRegularExpression& resolutionPattern()
+{
+    static const QRegularExpression pattern(
+        "\\b(2160|1440|1080|720|576|480|360)p\\b|\\b(4k|uhd)\\b",
+        QRegularExpression::CaseInsensitiveOption);
+    return pattern;
+}
+
+const QRegularExpression& sourcePattern()
+{
+    // Capture group index is the source kind, see sourceLevel()
+    static const QRegularExpression pattern(
+        "\\b(remux)\\b|\\b(blu-?ray|bdrip|brrip)\\b|\\b(web-?dl|web-?rip|web)\\b"
+        "|\\b(hdtv|pdtv|dvdrip|dvd)\\b|\\b(cam|hdcam|camrip|ts|hdts|telesync|tc)\\b",
+        QRegularExpression::CaseInsensitiveOption);
+    return pattern;
+}
+
+const QRegularExpression& codecPattern()
+{
+    static const QRegularExpression pattern(
+        "\\b(x265|h\\.?265|hevc)\\b|\\b(av1)\\b|\\b(x264|h\\.?264|avc)\\b",
+        QRegularExpression::CaseInsensitiveOption);
+    return pattern;
+}
+
+const QRegularExpression& hdrPattern()
+{
+    static const QRegularExpression pattern(
+        "\\b(dv|dovi|dolby[ .]?vision)\\b|\\b(hdr10\\+|hdr10plus)|\\b(hdr(?:10)?)\\b",
+        QRegularExpression::CaseInsensitiveOption);
+    return pattern;
+}
+
+const QRegularExpression& sizePattern()
+{
+    static const QRegularExpression pattern(
+        "(\\d+(?:[.,]\\d+)?)\\s*(tb|gb|mb)\\b",
+        QRegularExpression::CaseInsensitiveOption);
+    return pattern;
+}
+
+const QRegularExpression& seedersPattern()
+{
+    // Torrentio-style "👤 42", or "Seeders: 42"
+    static const QRegularExpression pattern(
+        "(?:\\x{1F464}|\\bseeders?:?|\\bseeds?:?)\\s*(\\d+)",
+        QRegularExpression::CaseInsensitiveOption);
+    return pattern;
+}
+
+const QRegularExpression& cachedPattern()
+{
+    // Debrid addons tag cached results, e.g. "[RD+]"
+    static const QRegularExpression pattern(
+        "\\[(rd|ad|pm|dl|tb|oc|ed)\\+\\]",
+        QRegularExpression::CaseInsensitiveOption);
+    return pattern;
+}
+
+const QRegularExpression& btihPattern()
+{
+    static const QRegularExpression pattern(
+        "xt=urn:btih:([0-9a-f]{40}|[a-z2-7]{32})",
+        QRegularExpression::CaseInsensitiveOption);
+    return pattern;
+}
+
+// cam < unknown < tv < web < bluray < remux
+int sourceLevel(int group)
+{
+    static const int levels[] = {0, 4, 3, 2, 1, -3};
+    return group > 0 && group <= 5 ? levels[group] : 0;
+}
+
+int resolutionStep(int resolution)
+{
+    if (resolution >= 2160) return 4;
+    if (resolution >= 1080) return 3;
+    if (resolution >= 720) return 2;
+    if (resolution > 0) return 1;
+    return 0;
+}
+
+int firstMatchedGroup(const QRegularExpressionMatch& match)
+{
+    for (int group = 1; group <= match.lastCapturedIndex(); ++group) {
+        if (match.capturedLength(group) > 0) {
+            return group;
+        }
+    }
+    return 0;
+}
+}
+
+StreamRanker::StreamRanker(const Weights& weights)
+    : m_weights(weights)
+{
+}
+
+StreamRanker::Weights StreamRanker::weightsFromVariantMap(const QVariantMap& map)
+{
+    Weights weights;
+    weights.resolution = map.value("resolution", weights.resolution).toInt();
+    weights.source = map.value("source", weights.source).toInt();
+    weights.hdr = map.value("hdr", weights.hdr).toInt();
+    weights.hevc = map.value("hevc", weights.hevc).toInt();
+    weights.cached = map.value("cached", weights.cached).toInt();
+    weights.seeders = map.value("seeders", weights.seeders).toInt();
+    weights.maxSizeBytes = map.value("maxSizeBytes", weights.maxSizeBytes).toLongLong();
+    weights.preferredResolution = map.value("preferredResolution", weights.preferredResolution).toInt();
+    return weights;
+}
+
+StreamRanker::Attributes StreamRanker::parse(const QVariantMap& stream)
+{
+    Attributes attributes;
+    QString text = stream["name"].toString() + '\n' + stream["title"].toString() + '\n'
+        + stream["description"].toString();
+
+    QRegularExpressionMatch match = resolutionPattern().match(text);
+    if (match.hasMatch()) {
+        attributes.resolution = match.capturedLength(2) > 0 ? 2160 : match.captured(1).toInt();
+    }
+
+    // "WEB-DL ... REMUX" is a remux; keep the best source named anywhere
+    bool sourceFound = false;
+    QRegularExpressionMatchIterator sourceMatches = sourcePattern().globalMatch(text);
+    while (sourceMatches.hasNext()) {
+        int level = sourceLevel(firstMatchedGroup(sourceMatches.next()));
+        if (!sourceFound || level > attributes.source) {
+            attributes.source = level;
+            sourceFound = true;
+        }
+    }
+
+    match = codecPattern().match(text);
+    if (match.hasMatch()) {
+        static const char* const codecs[] = {"", "hevc", "av1", "avc"};
+        attributes.codec = QString::fromLatin1(codecs[firstMatchedGroup(match)]);
+    }
+
+    // Releases often list several HDR formats; keep the best one
+    int bestHdr = 0;
+    QRegularExpressionMatchIterator hdrMatches = hdrPattern().globalMatch(text);
+    while (hdrMatches.hasNext()) {
+        int group = firstMatchedGroup(hdrMatches.next());
+        if (group > 0 && (bestHdr == 0 || group < bestHdr)) {
+            bestHdr = group;
+        }
+    }
+    static const char* const hdrFormats[] = {"", "dv", "hdr10+", "hdr"};
+    attributes.hdr = QString::fromLatin1(hdrFormats[bestHdr]);
+
+    attributes.size = stream["size"].isNull() ? -1 : stream["size"].toLongLong();
+    if (attributes.size < 0) {
+        match = sizePattern().match(text);
+        if (match.hasMatch()) {
+            double value = QString(match.captured(1)).replace(',', '.').toDouble();
+            QString unit = match.captured(2).toLower();
+            double multiplier = unit == "tb" ? 1024.0 * 1024 * 1024 * 1024
+                : unit == "gb" ? 1024.0 * 1024 * 1024 : 1024.0 * 1024;
+            attributes.size = static_cast<qint64>(value * multiplier);
+        }
+    }
+
+    match = seedersPattern().match(text);
+    if (match.hasMatch()) {
+        attributes.seeders = match.captured(1).toInt();
+    }
+
+    // Direct links and debrid-cached torrents play without a swarm
+    QString url = stream["url"].toString();
+    attributes.cached = stream["isDebrid"].toBool()
+        || cachedPattern().match(text).hasMatch()
+        || url.startsWith("http", Qt::CaseInsensitive);
+    return attributes;
+}
+
+QString StreamRanker::dedupKey(const QVariantMap& stream)
+{
+    QString url = stream["url"].toString();
+    QString infoHash = stream["infoHash"].toString().toLower();
+    if (infoHash.isEmpty()) {
+        QRegularExpressionMatch match = btihPattern().match(url);
+        if (match.hasMatch()) {
+            infoHash = match.captured(1).toLower();
+        }
+    }
+    if (!infoHash.isEmpty()) {
+        int fileIndex = stream["fileIdx"].isNull() ? -1 : stream["fileIdx"].toInt();
+        if (fileIndex < 0) {
+            // Magnet descriptors keep the file as BEP 53 "so"
+            bool ok = false;
+            int selectOnly = QUrlQuery(QUrl(url)).queryItemValue("so").toInt(&ok);
+            fileIndex = ok ? selectOnly : -1;
+        }
+        return QString("bt:%1:%2").arg(infoHash).arg(fileIndex);
+    }
+
+    QUrl normalized = QUrl(url).adjusted(QUrl::RemoveFragment | QUrl::StripTrailingSlash
+                                         | QUrl::NormalizePathSegments);
+    return "url:" + normalized.toString(QUrl::FullyEncoded);
+}
+
+int StreamRanker::score(const Attributes& attributes) const
+{
+    int score = 0;
+
+    int step = resolutionStep(attributes.resolution);
+    int preferredStep = resolutionStep(m_weights.preferredResolution);
+    if (preferredStep > 0 && step > 0) {
+        score += m_weights.resolution * (4 - qAbs(step - preferredStep));
+    } else {
+        score += m_weights.resolution * step;
+    }
+
+    score += m_weights.source * attributes.source;
+    if (!attributes.hdr.isEmpty()) {
+        score += m_weights.hdr;
+    }
+    if (attributes.codec == "hevc" || attributes.codec == "av1") {
+        score += m_weights.hevc;
+    }
+    if (attributes.cached) {
+        score += m_weights.cached;
+    }
+    if (attributes.seeders > 0) {
+        score += static_cast<int>(m_weights.seeders * std::log2(1.0 + attributes.seeders));
+    }
+    if (m_weights.maxSizeBytes > 0 && attributes.size > m_weights.maxSizeBytes) {
+        score -= 1000000; // over the user's size limit: after everything else
+    }
+    return score;
+}
+
+QVariantList StreamRanker::rank(const QVariantList& streams) const
+{
+    struct Entry {
+        qsizetype index;
+        int score;
+        QString key;
+        Attributes attributes;
+    };
+
+    // Parse and score every stream exactly once
+    std::vector<Entry> entries;
+    entries.reserve(static_cast<size_t>(streams.size()));
+    for (qsizetype i = 0; i < streams.size(); ++i) {
+        QVariantMap stream = streams.at(i).toMap();
+        Attributes attributes = parse(stream);
+        entries.push_back({i, score(attributes), dedupKey(stream), attributes});
+    }
+
+    // Stable, so equal scores keep addon order
+    std::stable_sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) {
+        return a.score > b.score;
+    });
+
+    QVariantList ranked;
+    ranked.reserve(static_cast<qsizetype>(entries.size()));
+    QSet<QString> seen;
+    seen.reserve(static_cast<qsizetype>(entries.size()));
+    for (const Entry& entry : entries) {
+        if (seen.contains(entry.key)) {
+            continue; // a better-scored copy is already listed
+        }
+        seen.insert(entry.key);
+
+        QVariantMap stream = streams.at(entry.index).toMap();
+        const Attributes& attributes = entry.attributes;
+        stream["resolution"] = attributes.resolution > 0 ? QVariant(attributes.resolution) : QVariant();
+        stream["codec"] = attributes.codec;
+        stream["hdr"] = attributes.hdr;
+        stream["seeders"] = attributes.seeders >= 0 ? QVariant(attributes.seeders) : QVariant();
+        stream["score"] = entry.score;
+        if (stream["size"].isNull() && attributes.size >= 0) {
+            stream["size"] = attributes.size;
+        }
+        if (stream["quality"].toString().isEmpty() && attributes.resolution > 0) {
+            stream["quality"] = attributes.resolution >= 2160
+                ? QStringLiteral("4K") : QString("%1p").arg(attributes.resolution);
+        }
+        ranked.append(stream);
+    }
+    return ranked;
+}
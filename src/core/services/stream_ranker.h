@@ -0,0 +1,77 @@
+#ifndef STREAM_RANKER_H
+#define STREAM_RANKER_H
+
+#include <QString>
+#include <QVariantMap>
+#include <QVariantList>
+
+/**
+ * @brief Collapses duplicate streams across addons and orders them by score
+ *
+ * Release attributes (resolution, source, codec, HDR, size, seeders) are
+ * parsed once per stream from its name, title and description with patterns
+ * compiled once per process. Streams are scored with user-adjustable weights
+ * and stable-sorted, so equal scores keep the order they were given in (addon
+ * order). Duplicates - the same info-hash and file, or the same normalised
+ * URL - collapse into their best-scored copy.
+ */
+class StreamRanker
+{
+public:
+    struct Weights {
+        int resolution = 100;   // per step: 480p < 720p < 1080p < 2160p
+        int source = 30;        // per step: cam < tv < web < bluray < remux
+        int hdr = 20;
+        int hevc = 10;          // HEVC/AV1 over AVC for the same resolution
+        int cached = 200;       // debrid-cached or direct HTTP streams
+        int seeders = 15;       // per doubling of seeders
+        qint64 maxSizeBytes = 0;    // larger streams rank last (0 = no limit)
+        int preferredResolution = 0; // e.g. 1080 ranks 1080p first (0 = highest first)
+    };
+
+    struct Attributes {
+        int resolution = 0;     // vertical lines, 0 = unknown
+        int source = 0;         // cam -3, unknown 0, tv 1, web 2, bluray 3, remux 4
+        QString codec;          // "hevc", "av1", "avc" or empty
+        QString hdr;            // "dv", "hdr10+", "hdr" or empty
+        qint64 size = -1;
+        int seeders = -1;
+        bool cached = false;
+    };
+
+    StreamRanker() = default;
+    explicit StreamRanker(const Weights& weights);
+
+    void setWeights(const Weights& weights) { m_weights = weights; }
+    const Weights& weights() const { return m_weights; }
+
+    /**
+     * @brief Weights from a QML map; missing keys keep their defaults
+     */
+    static Weights weightsFromVariantMap(const QVariantMap& map);
+
+    /**
+     * @brief Parse release attributes from a stream map
+     */
+    static Attributes parse(const QVariantMap& stream);
+
+    /**
+     * @brief Identity used to collapse duplicates: "<infohash>:<fileIdx>" or the normalised URL
+     */
+    static QString dedupKey(const QVariantMap& stream);
+
+    int score(const Attributes& attributes) const;
+
+    /**
+     * @brief De-duplicate and sort streams, best first
+     *
+     * Each returned stream gains resolution, codec, hdr, seeders and score
+     * keys, and a quality label when the addon did not provide one.
+     */
+    QVariantList rank(const QVariantList& streams) const;
+
+private:
+    Weights m_weights;
+};
+
+#endif // STREAM_RANKER_H
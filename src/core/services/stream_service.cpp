@@ -7,27 +7,57 @@
 #include "core/services/library_service.h"
 #include "core/services/id_parser.h"
 #include "core/services/torrent_service.h"
+#include "core/services/configuration.h"
+#include "core/services/addon_health_service.h"
+#include "core/services/cache_service.h"
+#include "core/services/navigation_service.h"
+#include "core/di/service_registry.h"
 #include "core/models/stream_info.h"
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QJsonArray>
 #include <QUrl>
 #include <QList>
+#include <QTimer>
+#include <QDateTime>
+#include <QRegularExpression>
 
 StreamService::StreamService(
     std::shared_ptr<AddonRepository> addonRepository,
     LibraryService* libraryService,
+    std::shared_ptr<TorrentService> torrentService,
     QObject* parent)
     : QObject(parent)
     , m_addonRepository(std::move(addonRepository))
     , m_libraryService(libraryService)
-    , m_torrentService(nullptr)
+    , m_torrentService(std::move(torrentService))
     , m_completedRequests(0)
     , m_totalRequests(0)
+    , m_generation(0)
+    , m_finalized(false)
+    , m_deadlineTimer(new QTimer(this))
+    , m_prefetchGeneration(0)
+    , m_prefetchPending(0)
 {
-    // Initialize torrent service if available
-    m_torrentService = new TorrentService(this);
-    if (!m_torrentService->isAvailable()) {
+    m_deadlineTimer->setSingleShot(true);
+    connect(m_deadlineTimer, &QTimer::timeout, this, [this]() {
+        qDebug() << "[StreamService] Addon deadline passed with" << (m_totalRequests - m_completedRequests)
+                 << "addon(s) outstanding";
+        finalizeStreams();
+    });
+    
+    // Leaving a screen abandons its stream lookup
+    if (auto navigation = ServiceRegistry::instance().resolve<NavigationService>()) {
+        connect(navigation.get(), &NavigationService::backRequested, this, &StreamService::cancelStreams);
+    }
+    
+    // The app has one torrent session; never build a second one here
+    if (!m_torrentService) {
+        m_torrentService = ServiceRegistry::instance().resolve<TorrentService>();
+    }
+    if (!m_torrentService) {
+        LoggingService::logError("StreamService", "TorrentService is not registered - torrent streaming disabled");
+    } else if (!m_torrentService->isAvailable()) {
         LoggingService::logInfo("StreamService", "Torrent support not available");
     }
 }
@@ -53,11 +83,6 @@ QString StreamService::extractImdbId(const QVariantMap& itemData)
     return QString();
 }
 
-QString StreamService::formatEpisodeId(int season, int episode)
-{
-    return QString("S%1E%2").arg(season, 2, 10, QChar('0')).arg(episode, 2, 10, QChar('0'));
-}
-
 void StreamService::getStreamsForItem(const QVariantMap& itemData, const QString& episodeId)
 {
     LoggingService::logDebug("StreamService", QString("Getting streams for item: %1 type: %2").arg(itemData["name"].toString(), itemData["type"].toString()));
@@ -65,10 +90,19 @@ void StreamService::getStreamsForItem(const QVariantMap& itemData, const QString
     m_currentItemData = itemData;
     m_currentEpisodeId = episodeId;
     m_allStreams.clear();
-    m_pendingRequests.clear();
     m_completedRequests = 0;
     m_totalRequests = 0;
     
+    // Replies to an earlier request are aborted, and ignored should one slip through
+    ++m_generation;
+    abortPendingRequests();
+    m_adoptedPrefetch.clear();
+    m_finalized = false;
+    m_addonOrder.clear();
+    m_addonStreams.clear();
+    m_emittedStreamKeys.clear();
+    m_deadlineTimer->stop();
+    
     if (!m_addonRepository) {
         LoggingService::report("Addon repository not initialized", "SERVICE_UNAVAILABLE", "StreamService");
         emit error("Addon repository not initialized");
@@ -79,30 +113,54 @@ void StreamService::getStreamsForItem(const QVariantMap& itemData, const QString
     QString imdbId = extractImdbId(itemData);
     if (imdbId.isEmpty()) {
         LoggingService::report("Could not get IMDB ID for item", "ID_EXTRACTION_ERROR", "StreamService");
+        abortPrefetch();
         emit error("Could not get IMDB ID for item");
         return;
     }
     
     m_currentImdbId = imdbId;
+    m_currentStreamType = addonType(itemData["type"].toString());
+    m_currentStreamId = streamIdFor(imdbId, episodeId);
+    // A prefetch of this very item keeps running and its answers are adopted
+    // below; one of another item would only compete with this request
+    if (m_prefetchKey != m_currentStreamType + "/" + m_currentStreamId) {
+        abortPrefetch();
+    }
     fetchStreamsFromAddons();
 }
 
-void StreamService::fetchStreamsFromAddons()
+QString StreamService::addonType(const QString& type)
+{
+    // Addons list shows as "series"; the app calls them "tv"
+    return type == "tv" ? QStringLiteral("series") : type;
+}
+
+QString StreamService::streamIdFor(const QString& imdbId, const QString& episodeId)
+{
+    if (episodeId.isEmpty()) {
+        return imdbId;
+    }
+    // "S01E02" from the UI becomes the Stremio video id "tt0903747:1:2"
+    static const QRegularExpression pattern("^S(\\d+)E(\\d+)$", QRegularExpression::CaseInsensitiveOption);
+    QRegularExpressionMatch match = pattern.match(episodeId);
+    if (!match.hasMatch()) {
+        return episodeId;
+    }
+    return QString("%1:%2:%3").arg(imdbId).arg(match.captured(1).toInt()).arg(match.captured(2).toInt());
+}
+
+QList<AddonConfig> StreamService::streamingAddonsFor(const QString& type) const
 {
+    QList<AddonConfig> streamingAddons;
     if (!m_addonRepository) {
-        LoggingService::report("Addon repository not initialized", "SERVICE_UNAVAILABLE", "StreamService");
-        emit error("Addon repository not initialized");
-        return;
+        return streamingAddons;
     }
     
-    QString type = m_currentItemData["type"].toString();
-    
     // Get enabled addons
     QList<AddonConfig> enabledAddons = m_addonRepository->getEnabledAddons();
     qDebug() << "[StreamService] Found" << enabledAddons.size() << "enabled addon(s)";
     
     // Filter addons that support streaming and the item type
-    QList<AddonConfig> streamingAddons;
     for (const AddonConfig& addon : enabledAddons) {
         AddonManifest manifest = m_addonRepository->getManifest(addon);
         if (manifest.id().isEmpty()) {
@@ -122,64 +180,262 @@ void StreamService::fetchStreamsFromAddons()
     
     qDebug() << "[StreamService]" << streamingAddons.size() << "addon(s) support streaming for" << type;
     
-    if (streamingAddons.isEmpty()) {
-        emit streamsLoaded(QVariantList());
+    // Addons that keep failing come last
+    if (auto health = ServiceRegistry::instance().resolve<AddonHealthService>()) {
+        health->sortAddons(streamingAddons, "stream");
+    }
+    return streamingAddons;
+}
+
+AddonClient* StreamService::createStreamClient(const AddonConfig& addon)
+{
+    AddonClient* client = new AddonClient(AddonClient::extractBaseUrl(addon.manifestUrl), this);
+    client->setAddonId(addon.id);
+    if (auto health = ServiceRegistry::instance().resolve<AddonHealthService>()) {
+        client->setTimeout(health->timeoutFor(addon.id, "stream"));
+    }
+    return client;
+}
+
+bool StreamService::allowStreamRequest(const QString& addonId)
+{
+    auto health = ServiceRegistry::instance().resolve<AddonHealthService>();
+    return !health || health->allowRequest(addonId, "stream");
+}
+
+void StreamService::fetchStreamsFromAddons()
+{
+    if (!m_addonRepository) {
+        LoggingService::report("Addon repository not initialized", "SERVICE_UNAVAILABLE", "StreamService");
+        emit error("Addon repository not initialized");
         return;
     }
     
-    // Determine stream ID (episode ID for TV, IMDB ID otherwise)
-    QString streamId = m_currentEpisodeId.isEmpty() ? m_currentImdbId : m_currentEpisodeId;
+    QString type = m_currentStreamType;
+    QString streamId = m_currentStreamId;
     qDebug() << "[StreamService] Using stream ID:" << streamId;
     
-    // Create AddonClient for each addon and fetch streams
-    m_totalRequests = streamingAddons.size();
+    // Fresh cached lists are used as they are, stale ones are shown while the
+    // addon is asked again. Addons that keep failing sit out their cooldown;
+    // the rest go healthiest first.
+    QList<AddonConfig> streamingAddons = streamingAddonsFor(type);
+    
+    struct AddonPlan {
+        AddonConfig addon;
+        CachedStreams cached;
+        bool request;
+        bool adopt;         // the prefetch already asked this addon; wait for its answer
+    };
+    bool prefetching = m_prefetchKey == type + "/" + streamId;
+    QList<AddonPlan> plan;
+    for (const AddonConfig& addon : std::as_const(streamingAddons)) {
+        CachedStreams cached = cachedStreams(addon.id, type, streamId);
+        bool adopt = !cached.fresh && prefetching && m_prefetchInFlight.contains(addon.id);
+        bool request = !cached.fresh && (adopt || allowStreamRequest(addon.id));
+        if (!cached.found && !request) {
+            qDebug() << "[StreamService] Skipping failing addon" << addon.name;
+            continue;
+        }
+        plan.append({addon, cached, request, adopt});
+    }
+    
+    if (plan.isEmpty()) {
+        m_finalized = true;
+        emit streamsLoaded(QVariantList());
+        return;
+    }
+    
+    // One answer per addon counts towards completion, cached or not
+    m_totalRequests = plan.size();
     m_completedRequests = 0;
     
-    for (const AddonConfig& addon : streamingAddons) {
-        QString baseUrl = AddonClient::extractBaseUrl(addon.manifestUrl);
-        AddonClient* client = new AddonClient(baseUrl, this);
+    auto config = ServiceRegistry::instance().resolve<Configuration>();
+    m_deadlineTimer->start(config ? config->streamAddonDeadlineMs() : 8000);
+    
+    int generation = m_generation;
+    for (const AddonPlan& entry : std::as_const(plan)) {
+        const AddonConfig& addon = entry.addon;
+        m_addonOrder.append(addon.id);
         
-        PendingRequest request;
-        request.addonId = addon.id;
-        request.addonName = addon.name;
-        request.type = type;
-        request.streamId = streamId;
-        m_pendingRequests.append(request);
+        if (entry.cached.found) {
+            qDebug() << "[StreamService] Using" << (entry.cached.fresh ? "cached" : "stale")
+                     << "streams from addon" << addon.name;
+            m_addonStreams.insert(addon.id, entry.cached.streams);
+            emitNewStreams(addon.id, entry.cached.streams);
+            m_completedRequests++;
+        }
+        if (!entry.request) {
+            continue;
+        }
+        if (entry.adopt) {
+            qDebug() << "[StreamService] Waiting for prefetched streams from addon" << addon.name;
+            m_adoptedPrefetch.insert(addon.id, {generation, entry.cached.found});
+            continue;
+        }
         
-        connect(client, &AddonClient::streamsFetched, this, &StreamService::onStreamsFetched);
-        connect(client, &AddonClient::error, this, &StreamService::onAddonError);
+        AddonClient* client = createStreamClient(addon);
+        m_activeClients.append(client);
         
-        qDebug() << "[StreamService] Requesting streams from addon" << addon.name << "for" << type << streamId;
+        // Each client answers exactly once, so it knows which addon it speaks for
+        QString addonId = addon.id;
+        QString addonName = addon.name;
+        bool revalidate = entry.cached.found;
+        connect(client, &AddonClient::streamsFetched, this,
+                [this, client, generation, addonId, addonName, revalidate](const QString&, const QString&, const QJsonArray& streams) {
+            client->deleteLater();
+            if (revalidate) {
+                onAddonRevalidated(generation, addonId, addonName, streams);
+            } else {
+                onAddonStreams(generation, addonId, addonName, streams);
+            }
+        });
+        connect(client, &AddonClient::error, this,
+                [this, client, generation, addonId, revalidate](const QString& errorMessage) {
+            client->deleteLater();
+            if (revalidate) {
+                // The stale list stays on screen and in the cache
+                qDebug() << "[StreamService] Revalidating addon" << addonId << "failed:" << errorMessage;
+            } else {
+                onAddonFailed(generation, addonId, errorMessage);
+            }
+        });
+        
+        qDebug() << "[StreamService]" << (revalidate ? "Revalidating" : "Requesting")
+                 << "streams from addon" << addon.name << "for" << type << streamId;
         client->getStreams(type, streamId);
     }
+    
+    checkAllRequestsComplete();
+}
+
+void StreamService::onAddonStreams(int generation, const QString& addonId, const QString& addonName,
+                                   const QJsonArray& streams)
+{
+    if (generation != m_generation) {
+        return; // answer to a request that has been superseded
+    }
+    
+    QVariantList processed = processStreamsFromAddon(addonId, addonName, streams);
+    storeCachedStreams(addonId, m_currentStreamType, m_currentStreamId, processed);
+    addAddonStreams(addonId, addonName, processed);
+}
+
+void StreamService::addAddonStreams(const QString& addonId, const QString& addonName, const QVariantList& processed)
+{
+    qDebug() << "[StreamService] Received" << processed.size() << "stream(s) from addon" << addonName;
+    m_addonStreams.insert(addonId, processed);
+    if (m_finalized) {
+        // Answered after the deadline: the dialog only takes full lists by now
+        m_allStreams = rankCollectedStreams();
+        emit streamsLoaded(m_allStreams);
+        return;
+    }
+    emitNewStreams(addonId, processed);
+    
+    m_completedRequests++;
+    checkAllRequestsComplete();
+}
+
+void StreamService::onAddonRevalidated(int generation, const QString& addonId, const QString& addonName,
+                                       const QJsonArray& streams)
+{
+    if (generation != m_generation) {
+        return;
+    }
+    
+    QVariantList processed = processStreamsFromAddon(addonId, addonName, streams);
+    storeCachedStreams(addonId, m_currentStreamType, m_currentStreamId, processed);
+    updateAddonStreams(addonId, addonName, processed);
 }
 
-void StreamService::onStreamsFetched(const QString& type, const QString& id, const QJsonArray& streams)
+void StreamService::updateAddonStreams(const QString& addonId, const QString& addonName, const QVariantList& processed)
 {
-    Q_UNUSED(type);
-    Q_UNUSED(id);
-    
-    // Find which addon this response is from
-    // We can't directly identify from the signal, so we'll use the first pending request
-    // In a more robust implementation, we'd track client->request mappings
-    if (m_pendingRequests.isEmpty()) {
-        qWarning() << "[StreamService] Received streams but no pending requests";
-        m_completedRequests++;
-        checkAllRequestsComplete();
+    if (processed == m_addonStreams.value(addonId)) {
+        qDebug() << "[StreamService] Streams from addon" << addonName << "unchanged";
         return;
     }
     
-    PendingRequest request = m_pendingRequests.takeFirst();
-    qDebug() << "[StreamService] Received" << streams.size() << "stream(s) from addon" << request.addonName;
+    qDebug() << "[StreamService] Streams from addon" << addonName << "changed, updating";
+    m_addonStreams.insert(addonId, processed);
+    if (!m_finalized) {
+        emitNewStreams(addonId, processed);
+        return;
+    }
+    m_allStreams = rankCollectedStreams();
+    emit streamsLoaded(m_allStreams);
+}
+
+void StreamService::emitNewStreams(const QString& addonId, const QVariantList& streams)
+{
+    // Hand out what is new right away; the fastest addon decides when the first stream shows
+    QVariantList batch;
+    const QVariantList ranked = m_ranker.rank(streams);
+    for (const QVariant& value : ranked) {
+        QString key = StreamRanker::dedupKey(value.toMap());
+        if (!m_emittedStreamKeys.contains(key)) {
+            m_emittedStreamKeys.insert(key);
+            batch.append(value);
+        }
+    }
+    if (!batch.isEmpty()) {
+        emit streamsBatchLoaded(addonId, batch);
+    }
+}
+
+QString StreamService::streamCacheKey(const QString& addonId, const QString& type, const QString& streamId)
+{
+    return CacheService::generateKey("streams", addonId, type + "/" + streamId);
+}
+
+StreamService::CachedStreams StreamService::cachedStreams(const QString& addonId, const QString& type,
+                                                          const QString& streamId) const
+{
+    CachedStreams cached;
+    QVariantMap entry = CacheService::getCache(streamCacheKey(addonId, type, streamId)).toMap();
+    if (entry.isEmpty()) {
+        return cached;
+    }
+    
+    auto config = ServiceRegistry::instance().resolve<Configuration>();
+    qint64 ttlMs = (config ? config->streamCacheTtlSeconds() : 60) * 1000LL;
+    qint64 ageMs = QDateTime::currentMSecsSinceEpoch() - entry["fetchedAt"].toLongLong();
+    cached.found = true;
+    cached.fresh = ageMs >= 0 && ageMs < ttlMs;
+    cached.streams = entry["streams"].toList();
+    return cached;
+}
+
+void StreamService::storeCachedStreams(const QString& addonId, const QString& type, const QString& streamId,
+                                       const QVariantList& streams)
+{
+    auto config = ServiceRegistry::instance().resolve<Configuration>();
+    int ttlSeconds = config ? config->streamCacheTtlSeconds() : 60;
+    int staleSeconds = config ? config->streamCacheStaleSeconds() : 30 * 60;
+    if (ttlSeconds <= 0 && staleSeconds <= 0) {
+        return; // caching disabled
+    }
     
-    processStreamsFromAddon(request.addonId, request.addonName, streams);
+    QVariantMap entry;
+    entry["fetchedAt"] = QDateTime::currentMSecsSinceEpoch();
+    entry["streams"] = streams;
+    CacheService::setCache(streamCacheKey(addonId, type, streamId), entry, qMax(ttlSeconds, staleSeconds));
+}
+
+void StreamService::onAddonFailed(int generation, const QString& addonId, const QString& errorMessage)
+{
+    if (generation != m_generation) {
+        return;
+    }
+    qWarning() << "[StreamService] Addon" << addonId << "error:" << errorMessage;
     
+    // Still count as completed
     m_completedRequests++;
     checkAllRequestsComplete();
 }
 
-void StreamService::processStreamsFromAddon(const QString& addonId, const QString& addonName, const QJsonArray& streams)
+QVariantList StreamService::processStreamsFromAddon(const QString& addonId, const QString& addonName, const QJsonArray& streams)
 {
+    QVariantList processed;
     for (const QJsonValue& value : streams) {
         if (!value.isObject()) {
             continue;
@@ -213,22 +469,19 @@ void StreamService::processStreamsFromAddon(const QString& addonId, const QStrin
                     continue;
                 }
                 
-                // Convert magnet link to streamable URL
+                // Keep the magnet unresolved; it only joins the torrent session
+                // once it is played (see PlayerBridge::resolveMediaUrl)
                 int fileIndex = -1;
                 if (streamObj.contains("fileIdx") && streamObj["fileIdx"].isDouble()) {
                     fileIndex = streamObj["fileIdx"].toInt();
                 }
                 
-                QString convertedUrl = convertMagnetToStreamUrl(streamUrl, fileIndex);
-                if (!convertedUrl.isEmpty()) {
-                    streamUrl = convertedUrl;
-                    LoggingService::logInfo("StreamService", 
-                        QString("Converted magnet link to streamable URL: %1").arg(streamUrl));
-                } else {
-                    LoggingService::logWarning("StreamService", 
-                        "Failed to convert magnet link to streamable URL");
-                    continue; // Skip this stream if conversion failed
+                streamUrl = m_torrentService->magnetDescriptor(streamUrl, fileIndex);
+                if (streamUrl.isEmpty()) {
+                    LoggingService::logWarning("StreamService", "Skipping stream with invalid magnet link");
+                    continue;
                 }
+                streamObj["url"] = streamUrl;
             }
             
             // Update streamObj with extracted URL if it was missing
@@ -252,62 +505,258 @@ void StreamService::processStreamsFromAddon(const QString& addonId, const QStrin
                 displayTitle = description;
             }
             
-            // Extract size from behaviorHints or top-level
-            int sizeInBytes = -1;
+            // Extract size from behaviorHints or top-level (may exceed 32 bits)
+            qint64 sizeInBytes = -1;
             if (streamObj.contains("behaviorHints") && streamObj["behaviorHints"].isObject()) {
                 QJsonObject behaviorHints = streamObj["behaviorHints"].toObject();
                 if (behaviorHints.contains("videoSize")) {
-                    sizeInBytes = behaviorHints["videoSize"].toInt(-1);
+                    sizeInBytes = behaviorHints["videoSize"].toInteger(-1);
                 }
             }
             if (sizeInBytes < 0 && streamObj.contains("size")) {
-                sizeInBytes = streamObj["size"].toInt(-1);
+                sizeInBytes = streamObj["size"].toInteger(-1);
             }
             
             // Create StreamInfo
             StreamInfo info = StreamInfo::fromJson(streamObj, addonId, addonName);
             info.title = displayTitle;
+            info.isTorrent = m_torrentService && m_torrentService->isMagnetLink(streamUrl);
             if (sizeInBytes >= 0) {
                 info.size = sizeInBytes;
             }
             
             // Convert to QVariantMap for QML
-            QVariantMap streamMap = info.toVariantMap();
-            m_allStreams.append(streamMap);
+            processed.append(info.toVariantMap());
             
         } catch (const std::exception& e) {
             qWarning() << "[StreamService] Failed to process stream:" << e.what();
         }
     }
+    return processed;
+}
+
+void StreamService::setRankingWeights(const QVariantMap& weights)
+{
+    m_ranker.setWeights(StreamRanker::weightsFromVariantMap(weights));
+}
+
+void StreamService::cancelStreams()
+{
+    if (m_activeClients.isEmpty() && m_finalized) {
+        return;
+    }
+    qDebug() << "[StreamService] Cancelling stream request";
+    ++m_generation;
+    abortPendingRequests();
+    m_adoptedPrefetch.clear();
+    m_deadlineTimer->stop();
+    m_finalized = true;
+}
+
+void StreamService::abortPendingRequests()
+{
+    for (const QPointer<AddonClient>& client : std::as_const(m_activeClients)) {
+        if (client) {
+            client->abort();
+            client->deleteLater();
+        }
+    }
+    m_activeClients.clear();
 }
 
 void StreamService::checkAllRequestsComplete()
 {
     if (m_completedRequests >= m_totalRequests) {
-        qDebug() << "[StreamService] All requests complete. Total streams:" << m_allStreams.size();
-        emit streamsLoaded(m_allStreams);
+        finalizeStreams();
     }
 }
 
-void StreamService::onAddonError(const QString& errorMessage)
+void StreamService::finalizeStreams()
 {
-    qWarning() << "[StreamService] Addon error:" << errorMessage;
+    m_deadlineTimer->stop();
+    if (m_finalized) {
+        return;
+    }
+    m_finalized = true;
     
-    // Still count as completed
-    if (!m_pendingRequests.isEmpty()) {
-        m_pendingRequests.removeFirst();
+    m_allStreams = rankCollectedStreams();
+    
+    qDebug() << "[StreamService]" << m_completedRequests << "of" << m_totalRequests
+             << "addon(s) answered. Total streams:" << m_allStreams.size();
+    auto config = ServiceRegistry::instance().resolve<Configuration>();
+    warmTorrentStreams(m_allStreams, config ? config->torrentWarmTopN() : 0);
+    emit streamsLoaded(m_allStreams);
+}
+
+QVariantList StreamService::rankCollectedStreams() const
+{
+    // Collected in addon order, so ranking ties never depend on which addon
+    // answered first
+    QVariantList collected;
+    for (const QString& addonId : m_addonOrder) {
+        collected.append(m_addonStreams.value(addonId));
     }
-    m_completedRequests++;
-    checkAllRequestsComplete();
+    return m_ranker.rank(collected);
 }
 
-QString StreamService::convertMagnetToStreamUrl(const QString& url, int fileIndex)
+void StreamService::warmTorrentStreams(const QVariantList& rankedStreams, int count)
 {
     if (!m_torrentService || !m_torrentService->isAvailable()) {
-        return QString();
+        return;
     }
+    int warmCount = count;
     
-    return m_torrentService->getStreamUrl(url, fileIndex);
+    // Start metadata and startup pieces for the most likely picks
+    for (const QVariant& value : rankedStreams) {
+        if (warmCount <= 0) {
+            break;
+        }
+        QVariantMap stream = value.toMap();
+        if (!stream["isTorrent"].toBool()) {
+            continue;
+        }
+        QString warmedUrl = m_torrentService->getStreamUrl(stream["url"].toString());
+        if (!warmedUrl.isEmpty()) {
+            LoggingService::logDebug("StreamService", QString("Warming torrent stream: %1").arg(warmedUrl));
+        }
+        --warmCount;
+    }
 }
 
+void StreamService::prefetchStreams(const QVariantMap& itemData, const QString& episodeId)
+{
+    auto config = ServiceRegistry::instance().resolve<Configuration>();
+    if (!config || !config->streamPrefetchEnabled() || !m_addonRepository) {
+        return;
+    }
+    
+    QString imdbId = extractImdbId(itemData);
+    if (imdbId.isEmpty()) {
+        return;
+    }
+    QString type = addonType(itemData["type"].toString());
+    QString streamId = streamIdFor(imdbId, episodeId);
+    QString key = type + "/" + streamId;
+    if (key == m_prefetchKey) {
+        return; // in flight
+    }
+    if (!m_finalized && type == m_currentStreamType && streamId == m_currentStreamId) {
+        return; // being fetched for the stream dialog right now
+    }
+    if (!m_adoptedPrefetch.isEmpty()) {
+        return; // the stream dialog is waiting on the current prefetch
+    }
+    
+    abortPrefetch();
+    m_prefetchKey = key;
+    int generation = ++m_prefetchGeneration;
+    
+    // Fresh cache entries count as answered; everything else is asked, within
+    // the same health limits as a foreground request
+    const QList<AddonConfig> streamingAddons = streamingAddonsFor(type);
+    for (const AddonConfig& addon : streamingAddons) {
+        CachedStreams cached = cachedStreams(addon.id, type, streamId);
+        if (cached.fresh) {
+            m_prefetchStreams.append(cached.streams);
+            continue;
+        }
+        if (!allowStreamRequest(addon.id)) {
+            continue;
+        }
+        
+        AddonClient* client = createStreamClient(addon);
+        m_prefetchClients.append(client);
+        m_prefetchInFlight.insert(addon.id);
+        ++m_prefetchPending;
+        
+        QString addonId = addon.id;
+        QString addonName = addon.name;
+        connect(client, &AddonClient::streamsFetched, this,
+                [this, client, generation, addonId, addonName, type, streamId](const QString&, const QString&, const QJsonArray& streams) {
+            client->deleteLater();
+            if (generation != m_prefetchGeneration) {
+                return;
+            }
+            m_prefetchInFlight.remove(addonId);
+            QVariantList processed = processStreamsFromAddon(addonId, addonName, streams);
+            storeCachedStreams(addonId, type, streamId, processed);
+            
+            // Play was pressed while this addon was being asked
+            auto adopted = m_adoptedPrefetch.constFind(addonId);
+            if (adopted != m_adoptedPrefetch.constEnd()) {
+                AdoptedPrefetch request = *adopted;
+                m_adoptedPrefetch.erase(adopted);
+                if (request.generation == m_generation) {
+                    if (request.revalidate) {
+                        updateAddonStreams(addonId, addonName, processed);
+                    } else {
+                        addAddonStreams(addonId, addonName, processed);
+                    }
+                }
+            }
+            onPrefetchAnswered(generation, processed);
+        });
+        connect(client, &AddonClient::error, this, [this, client, generation, addonId](const QString& errorMessage) {
+            client->deleteLater();
+            if (generation != m_prefetchGeneration) {
+                return;
+            }
+            m_prefetchInFlight.remove(addonId);
+            AdoptedPrefetch request = m_adoptedPrefetch.take(addonId);
+            if (request.generation > 0 && !request.revalidate) {
+                onAddonFailed(request.generation, addonId, errorMessage);
+            }
+            onPrefetchAnswered(generation, QVariantList());
+        });
+        client->getStreams(type, streamId);
+    }
+    
+    qDebug() << "[StreamService] Prefetching streams for" << type << streamId << "from"
+             << m_prefetchPending << "addon(s)";
+    if (m_prefetchPending == 0) {
+        onPrefetchAnswered(generation, QVariantList());
+    }
+}
 
+void StreamService::onPrefetchAnswered(int generation, const QVariantList& streams)
+{
+    if (generation != m_prefetchGeneration) {
+        return;
+    }
+    m_prefetchStreams.append(streams);
+    if (m_prefetchPending > 0 && --m_prefetchPending > 0) {
+        return;
+    }
+    
+    // Rank once everything is in, so the warmed torrents are the ones the
+    // stream dialog will list first
+    m_prefetchClients.clear();
+    const QVariantList ranked = m_ranker.rank(m_prefetchStreams);
+    m_prefetchStreams.clear();
+    qDebug() << "[StreamService] Prefetched" << ranked.size() << "stream(s) for" << m_prefetchKey;
+    // Done: the results live in the stream cache, so focusing the item again is
+    // answered from there while fresh and asks the addons again once expired
+    m_prefetchKey.clear();
+    
+    auto config = ServiceRegistry::instance().resolve<Configuration>();
+    warmTorrentStreams(ranked, config ? config->streamPrefetchWarmTopN() : 0);
+}
+
+void StreamService::abortPrefetch()
+{
+    if (m_prefetchPending == 0) {
+        return;
+    }
+    ++m_prefetchGeneration;
+    for (const QPointer<AddonClient>& client : std::as_const(m_prefetchClients)) {
+        if (client) {
+            client->abort();
+            client->deleteLater();
+        }
+    }
+    m_prefetchClients.clear();
+    m_prefetchInFlight.clear();
+    m_prefetchStreams.clear();
+    m_prefetchPending = 0;
+    m_prefetchKey.clear();
+}
@@ -5,14 +5,22 @@
 #include <QVariantList>
 #include <QVariantMap>
 #include <QString>
+#include <QHash>
+#include <QSet>
+#include <QStringList>
+#include <QPointer>
 #include <memory>
 #include <QtQmlIntegration/qqmlintegration.h>
 #include "../models/stream_info.h"
+#include "stream_ranker.h"
 #include "interfaces/istream_service.h"
 
 class AddonRepository;
+class AddonClient;
+struct AddonConfig;
 class LibraryService;
 class TorrentService;
+class QTimer;
 
 class StreamService : public QObject, public IStreamService
 {
@@ -23,50 +31,132 @@ public:
     explicit StreamService(
         std::shared_ptr<AddonRepository> addonRepository,
         LibraryService* libraryService = nullptr,
+        std::shared_ptr<TorrentService> torrentService = nullptr,
         QObject* parent = nullptr);
     ~StreamService() override = default;
     
     // Get streams for a catalog item
     // itemData: QVariantMap with id, type, name, etc.
-    // episodeId: Optional episode ID for TV shows (format: "S01E01")
+    // episodeId: Optional episode ID for TV shows ("S01E01" or "tt0903747:1:1")
     Q_INVOKABLE void getStreamsForItem(const QVariantMap& itemData, const QString& episodeId = QString());
     
+    /**
+     * @brief Adjust how streams are ranked
+     * @param weights Map with any of resolution, source, hdr, hevc, cached, seeders,
+     *        maxSizeBytes and preferredResolution (see StreamRanker::Weights)
+     */
+    Q_INVOKABLE void setRankingWeights(const QVariantMap& weights);
+    
+    /**
+     * @brief Drop the current request
+     *
+     * Outstanding addon replies are aborted before they are parsed and no
+     * further signal is emitted for the request. Called on back navigation.
+     */
+    Q_INVOKABLE void cancelStreams();
+    
+    /**
+     * @brief Resolve streams of an item ahead of a likely Play
+     *
+     * Used while the next episode's continue watching card or detail page is
+     * in view. Addon answers go into the stream cache and the best torrent(s)
+     * get their metadata fetched, so getStreamsForItem for the same item can
+     * answer from the cache, or take over the replies still outstanding
+     * instead of asking the addons again. Emits nothing. Only runs with
+     * YANTRIUM_STREAM_PREFETCH set; a new prefetch replaces the previous one.
+     * @param episodeId Same format as for getStreamsForItem
+     */
+    Q_INVOKABLE void prefetchStreams(const QVariantMap& itemData, const QString& episodeId = QString());
+    
 signals:
+    /**
+     * @brief Streams of one addon, emitted as soon as it answers
+     *
+     * Only streams not already emitted by an earlier batch of the same request
+     * are included, so batches can be appended as they arrive.
+     */
+    void streamsBatchLoaded(const QString& addonId, const QVariantList& streams);
+    /**
+     * @brief Final list once every addon answered or the addon deadline passed
+     *
+     * Duplicates across addons collapsed and ranked best first; ties keep addon order.
+     * Emitted again with the updated list if a cached addon answer that was
+     * shown while being refreshed turns out to have changed.
+     */
     void streamsLoaded(const QVariantList& streams);
     void error(const QString& errorMessage);
-
-private slots:
-    void onStreamsFetched(const QString& type, const QString& id, const QJsonArray& streams);
-    void onAddonError(const QString& errorMessage);
     
 private:
-    struct PendingRequest {
-        QString addonId;
-        QString addonName;
-        QString type;
-        QString streamId;
+    struct CachedStreams {
+        QVariantList streams;
+        bool found = false;
+        bool fresh = false;     // younger than the TTL: no need to ask the addon
+    };
+    
+    struct AdoptedPrefetch {
+        int generation = 0;     // request waiting for the prefetch answer
+        bool revalidate = false;
     };
     
     QString extractImdbId(const QVariantMap& itemData);
-    QString formatEpisodeId(int season, int episode);
+    static QString addonType(const QString& type);
+    static QString streamIdFor(const QString& imdbId, const QString& episodeId);
+    QList<AddonConfig> streamingAddonsFor(const QString& type) const;
+    AddonClient* createStreamClient(const AddonConfig& addon);
+    static bool allowStreamRequest(const QString& addonId);
     void fetchStreamsFromAddons();
-    void processStreamsFromAddon(const QString& addonId, const QString& addonName, const QJsonArray& streams);
+    void abortPendingRequests();
+    void onAddonStreams(int generation, const QString& addonId, const QString& addonName, const QJsonArray& streams);
+    void onAddonFailed(int generation, const QString& addonId, const QString& errorMessage);
+    void onAddonRevalidated(int generation, const QString& addonId, const QString& addonName, const QJsonArray& streams);
+    void addAddonStreams(const QString& addonId, const QString& addonName, const QVariantList& processed);
+    void updateAddonStreams(const QString& addonId, const QString& addonName, const QVariantList& processed);
+    void emitNewStreams(const QString& addonId, const QVariantList& streams);
+    static QString streamCacheKey(const QString& addonId, const QString& type, const QString& streamId);
+    CachedStreams cachedStreams(const QString& addonId, const QString& type, const QString& streamId) const;
+    void storeCachedStreams(const QString& addonId, const QString& type, const QString& streamId,
+                            const QVariantList& streams);
+    QVariantList rankCollectedStreams() const;
+    QVariantList processStreamsFromAddon(const QString& addonId, const QString& addonName, const QJsonArray& streams);
     void checkAllRequestsComplete();
-    QString convertMagnetToStreamUrl(const QString& url, int fileIndex = -1);
+    void finalizeStreams();
+    void warmTorrentStreams(const QVariantList& rankedStreams, int count);
+    void onPrefetchAnswered(int generation, const QVariantList& streams);
+    void abortPrefetch();
     
     std::shared_ptr<AddonRepository> m_addonRepository;
     LibraryService* m_libraryService;
-    TorrentService* m_torrentService;
+    std::shared_ptr<TorrentService> m_torrentService;
+    StreamRanker m_ranker;
     
     QVariantList m_allStreams;
-    QList<PendingRequest> m_pendingRequests;
     int m_completedRequests;
     int m_totalRequests;
     
+    // Progressive delivery of the current request
+    int m_generation;                        // bumped per request; older replies are dropped
+    bool m_finalized;                        // streamsLoaded already emitted
+    QStringList m_addonOrder;                // addon ids in configured order
+    QHash<QString, QVariantList> m_addonStreams; // addon id -> its streams
+    QSet<QString> m_emittedStreamKeys;       // streams already sent in a batch
+    QTimer* m_deadlineTimer;
+    QList<QPointer<AddonClient>> m_activeClients; // clients of the current request
+    
     // Current request context
     QVariantMap m_currentItemData;
     QString m_currentEpisodeId;
     QString m_currentImdbId;
+    QString m_currentStreamType;
+    QString m_currentStreamId;               // "<imdb>:<season>:<episode>" for series, IMDB id otherwise
+    
+    // Background prefetch, independent of the current request
+    QString m_prefetchKey;                   // "<type>/<streamId>" being prefetched
+    int m_prefetchGeneration;
+    int m_prefetchPending;                   // addons yet to answer
+    QVariantList m_prefetchStreams;
+    QList<QPointer<AddonClient>> m_prefetchClients;
+    QSet<QString> m_prefetchInFlight;        // addons the prefetch still waits for
+    QHash<QString, AdoptedPrefetch> m_adoptedPrefetch; // addon id -> request using its prefetch answer
 };
 
 #endif // STREAM_SERVICE_H
@@ -0,0 +1,267 @@
+#include "torrent_piece_stream.h"
+
+#ifdef TORRENT_SUPPORT_ENABLED
+#include "torrent_stream_scheduler.h"
+#include "logging_service.h"
+#include <libtorrent/error_code.hpp>
+#include <cstring>
+#include <utility>
+
+TorrentPieceStream::TorrentPieceStream(const libtorrent::torrent_handle& handle,
+                                       std::shared_ptr<TorrentStreamScheduler> scheduler,
+                                       libtorrent::file_index_t fileIndex,
+                                       qint64 start, qint64 end,
+                                       qint64 windowBytes,
+                                       const QString& filePath,
+                                       QObject* parent)
+    : QIODevice(parent)
+    , m_handle(handle)
+    , m_scheduler(std::move(scheduler))
+    , m_cursor(0)
+    , m_pieceLength(1)
+    , m_file(filePath)
+    , m_fileOffset(0)
+    , m_startOffset(0)
+    , m_endOffset(0)
+    , m_readOffset(0)
+    , m_windowPieces(2)
+    , m_lastPiece(-1)
+    , m_nextRequestPiece(0)
+    , m_nextDeliverPiece(0)
+    , m_bufferedBytes(0)
+    , m_firstBytesRead(false)
+{
+    auto ti = m_handle.torrent_file();
+    if (ti) {
+        const libtorrent::file_storage& files = ti->files();
+        m_fileOffset = files.file_offset(fileIndex);
+        m_pieceLength = ti->piece_length();
+        m_startOffset = m_fileOffset + start;
+        m_endOffset = m_fileOffset + end + 1;
+        m_readOffset = m_startOffset;
+        m_windowPieces = static_cast<int>(qMax<qint64>(2, windowBytes / m_pieceLength));
+        m_nextRequestPiece = pieceAt(m_startOffset);
+        m_nextDeliverPiece = m_nextRequestPiece;
+        m_lastPiece = pieceAt(m_endOffset - 1);
+    }
+    if (m_scheduler) {
+        m_cursor = m_scheduler->openCursor(m_startOffset);
+    }
+
+    open(QIODevice::ReadOnly | QIODevice::Unbuffered);
+}
+
+TorrentPieceStream::~TorrentPieceStream()
+{
+    if (m_servingTimer.isValid()) {
+        emit servingFinished(m_readOffset - m_startOffset, m_servingTimer.elapsed());
+    }
+    if (!m_scheduler) {
+        return;
+    }
+    // Give back requests for pieces that were never delivered
+    for (int piece = m_nextDeliverPiece; piece < m_nextRequestPiece; ++piece) {
+        if (!m_pendingPieces.contains(piece)) {
+            m_scheduler->releasePiece(piece);
+        }
+    }
+    m_scheduler->closeCursor(m_cursor);
+}
+
+void TorrentPieceStream::begin()
+{
+    requestPieces();
+    if (collectReadyPieces()) {
+        emit readyRead();
+    }
+}
+
+int TorrentPieceStream::pieceAt(qint64 torrentOffset) const
+{
+    return static_cast<int>(torrentOffset / m_pieceLength);
+}
+
+bool TorrentPieceStream::wantsPiece(libtorrent::piece_index_t piece) const
+{
+    int index = static_cast<int>(piece);
+    return index >= m_nextDeliverPiece && index < m_nextRequestPiece
+        && !m_pendingPieces.contains(index);
+}
+
+void TorrentPieceStream::requestPieces()
+{
+    if (!m_handle.is_valid() || !m_scheduler) {
+        return;
+    }
+
+    // Only look windowPieces ahead of what the reader has consumed, so memory
+    // stays bounded even if the socket drains slower than the swarm delivers
+    int readerPiece = pieceAt(m_readOffset);
+    int lastAllowed = qMin(m_lastPiece, readerPiece + m_windowPieces - 1);
+
+    for (; m_nextRequestPiece <= lastAllowed; ++m_nextRequestPiece) {
+        Chunk chunk;
+        bool direct = !m_file.fileName().isEmpty() && m_scheduler->isOnDisk(m_nextRequestPiece);
+        if (direct && makeChunk(m_nextRequestPiece, m_pieceLength, chunk)) {
+            // Already in the downloaded file: no read_piece round trip or copy
+            m_pendingPieces.insert(m_nextRequestPiece, chunk);
+        } else {
+            m_scheduler->requestPiece(m_nextRequestPiece);
+        }
+    }
+}
+
+bool TorrentPieceStream::makeChunk(int piece, qint64 size, Chunk& chunk) const
+{
+    // Trim the piece to the part that falls inside the requested range
+    qint64 pieceStart = static_cast<qint64>(piece) * m_pieceLength;
+    qint64 from = qMax(pieceStart, m_startOffset);
+    qint64 to = qMin(pieceStart + size, m_endOffset);
+    if (to <= from) {
+        return false;
+    }
+    chunk.filePosition = pieceStart - m_fileOffset;
+    chunk.begin = static_cast<int>(from - pieceStart);
+    chunk.end = static_cast<int>(to - pieceStart);
+    return true;
+}
+
+void TorrentPieceStream::fail(const QString& error)
+{
+    emit streamFailed(error);
+    close();
+}
+
+void TorrentPieceStream::onPieceRead(libtorrent::piece_index_t piece,
+                                     const boost::shared_array<char>& buffer,
+                                     int size, const libtorrent::error_code& error)
+{
+    if (!wantsPiece(piece)) {
+        return;
+    }
+
+    int index = static_cast<int>(piece);
+    if (error) {
+        QString message = QString::fromStdString(error.message());
+        LoggingService::logError("TorrentPieceStream",
+            QString("Failed to read piece %1: %2").arg(index).arg(message));
+        fail(message);
+        return;
+    }
+
+    Chunk chunk;
+    if (!makeChunk(index, size, chunk)) {
+        return;
+    }
+    chunk.buffer = buffer;
+    m_pendingPieces.insert(index, chunk);
+
+    deliverReadyPieces();
+}
+
+bool TorrentPieceStream::collectReadyPieces()
+{
+    bool delivered = false;
+    auto it = m_pendingPieces.find(m_nextDeliverPiece);
+    while (it != m_pendingPieces.end()) {
+        m_bufferedBytes += it->end - it->begin;
+        m_chunks.append(*it);
+        m_pendingPieces.erase(it);
+        ++m_nextDeliverPiece;
+        delivered = true;
+        it = m_pendingPieces.find(m_nextDeliverPiece);
+    }
+    return delivered;
+}
+
+void TorrentPieceStream::deliverReadyPieces()
+{
+    if (collectReadyPieces()) {
+        if (m_stallTimer.isValid()) {
+            emit stalled(m_stallTimer.elapsed());
+            m_stallTimer.invalidate();
+        }
+        emit readyRead();
+    }
+}
+
+qint64 TorrentPieceStream::bytesAvailable() const
+{
+    return m_bufferedBytes + QIODevice::bytesAvailable();
+}
+
+bool TorrentPieceStream::atEnd() const
+{
+    return !isOpen() || (m_bufferedBytes == 0 && m_readOffset >= m_endOffset);
+}
+
+qint64 TorrentPieceStream::readData(char* data, qint64 maxSize)
+{
+    if (atEnd()) {
+        return -1;
+    }
+
+    qint64 copied = 0;
+    QString readError;
+    while (copied < maxSize && !m_chunks.isEmpty() && readError.isEmpty()) {
+        qint64 batchStart = copied;
+        while (copied < maxSize && !m_chunks.isEmpty()) {
+            Chunk& chunk = m_chunks.first();
+            qint64 count = qMin<qint64>(maxSize - copied, chunk.end - chunk.begin);
+            if (chunk.buffer) {
+                std::memcpy(data + copied, chunk.buffer.get() + chunk.begin, static_cast<size_t>(count));
+            } else {
+                // Read from the file straight into the caller's buffer
+                if ((!m_file.isOpen() && !m_file.open(QIODevice::ReadOnly))
+                    || !m_file.seek(chunk.filePosition + chunk.begin)
+                    || m_file.read(data + copied, count) != count) {
+                    readError = m_file.errorString();
+                    break;
+                }
+            }
+            chunk.begin += static_cast<int>(count);
+            copied += count;
+            if (chunk.begin >= chunk.end) {
+                m_chunks.removeFirst();
+            }
+        }
+
+        qint64 batch = copied - batchStart;
+        if (batch == 0) {
+            break;
+        }
+        m_bufferedBytes -= batch;
+        m_readOffset += batch;
+        if (!m_firstBytesRead) {
+            m_firstBytesRead = true;
+            m_servingTimer.start();
+            emit firstBytesRead();
+        }
+        m_scheduler->advanceCursor(m_cursor, m_readOffset);
+        // Pieces that were on disk become readable right away
+        requestPieces();
+        collectReadyPieces();
+    }
+    if (!readError.isEmpty()) {
+        LoggingService::logError("TorrentPieceStream",
+            QString("Failed to read %1: %2").arg(m_file.fileName(), readError));
+        emit streamFailed(readError);
+        return copied > 0 ? copied : -1;
+    }
+    if (m_readOffset >= m_endOffset) {
+        emit readChannelFinished();
+    } else if (m_chunks.isEmpty() && m_firstBytesRead) {
+        // Drained: the reader now waits for the swarm
+        m_stallTimer.start();
+    }
+
+    return copied;
+}
+
+qint64 TorrentPieceStream::writeData(const char* data, qint64 maxSize)
+{
+    Q_UNUSED(data);
+    Q_UNUSED(maxSize);
+    return -1;
+}
+#endif // TORRENT_SUPPORT_ENABLED
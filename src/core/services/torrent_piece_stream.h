@@ -0,0 +1,131 @@
+#ifndef TORRENT_PIECE_STREAM_H
+#define TORRENT_PIECE_STREAM_H
+
+#include <QIODevice>
+#include <QFile>
+#include <QList>
+#include <QMap>
+#include <QElapsedTimer>
+#include <memory>
+
+#ifdef TORRENT_SUPPORT_ENABLED
+#include <libtorrent/torrent_handle.hpp>
+#include <libtorrent/torrent_info.hpp>
+#include <boost/shared_array.hpp>
+
+class TorrentStreamScheduler;
+
+/**
+ * @brief Sequential QIODevice that streams a byte range of a torrent file
+ *
+ * Walks every piece covered by [start, end] in order, requests each piece
+ * through the torrent's TorrentStreamScheduler and hands bytes to the reader as
+ * soon as the next piece in sequence has been read. At most windowBytes worth of pieces ahead of the
+ * reader are requested or held in memory at any time.
+ *
+ * Pieces the scheduler knows to be on disk are read straight from the
+ * downloaded file into the reader's buffer. Only the remaining pieces go
+ * through read_piece, whose data is fed in by TorrentStreamServer (which owns
+ * alert dispatch).
+ */
+class TorrentPieceStream : public QIODevice
+{
+    Q_OBJECT
+
+public:
+    TorrentPieceStream(const libtorrent::torrent_handle& handle,
+                       std::shared_ptr<TorrentStreamScheduler> scheduler,
+                       libtorrent::file_index_t fileIndex,
+                       qint64 start, qint64 end,
+                       qint64 windowBytes,
+                       const QString& filePath,
+                       QObject* parent = nullptr);
+    ~TorrentPieceStream() override;
+
+    /**
+     * @brief Request the first window of pieces
+     */
+    void begin();
+
+    /**
+     * @brief Deliver the result of a read_piece_alert for this torrent
+     */
+    void onPieceRead(libtorrent::piece_index_t piece, const boost::shared_array<char>& buffer,
+                     int size, const libtorrent::error_code& error);
+
+    /**
+     * @brief Stop streaming: emits streamFailed and closes the device
+     */
+    void fail(const QString& error);
+
+    /**
+     * @brief Whether this stream is still waiting for the given piece
+     */
+    bool wantsPiece(libtorrent::piece_index_t piece) const;
+
+    const libtorrent::torrent_handle& handle() const { return m_handle; }
+    qint64 contentLength() const { return m_endOffset - m_startOffset; }
+
+    bool isSequential() const override { return true; }
+    qint64 bytesAvailable() const override;
+    bool atEnd() const override;
+
+signals:
+    void streamFailed(const QString& error);
+    void firstBytesRead();
+    /**
+     * @brief The reader had consumed everything and waited stallMs for the next piece
+     */
+    void stalled(qint64 stallMs);
+    /**
+     * @brief Emitted on destruction: bytes handed out since the first byte, and over how long
+     */
+    void servingFinished(qint64 bytes, qint64 elapsedMs);
+
+protected:
+    qint64 readData(char* data, qint64 maxSize) override;
+    qint64 writeData(const char* data, qint64 maxSize) override;
+
+private:
+    // Piece bytes [begin, end), either held in memory or (when buffer is null)
+    // read from the downloaded file at filePosition + begin
+    struct Chunk {
+        boost::shared_array<char> buffer;
+        qint64 filePosition = 0;
+        int begin = 0;
+        int end = 0;
+    };
+
+    int pieceAt(qint64 torrentOffset) const;
+    bool makeChunk(int piece, qint64 size, Chunk& chunk) const;
+    void requestPieces();
+    bool collectReadyPieces();
+    void deliverReadyPieces();
+
+    libtorrent::torrent_handle m_handle;
+    std::shared_ptr<TorrentStreamScheduler> m_scheduler;
+    int m_cursor;           // this connection's read cursor in the scheduler
+    int m_pieceLength;
+    QFile m_file;           // downloaded file, opened on first direct read
+    qint64 m_fileOffset;    // absolute offset of the file's first byte
+
+    // Absolute offsets into the torrent's concatenated file space
+    qint64 m_startOffset;
+    qint64 m_endOffset;     // exclusive
+    qint64 m_readOffset;    // next byte handed to the reader
+
+    int m_windowPieces;
+    int m_lastPiece;
+    int m_nextRequestPiece;
+    int m_nextDeliverPiece;
+
+    QMap<int, Chunk> m_pendingPieces; // read out of order, waiting for predecessors
+    QList<Chunk> m_chunks;            // contiguous bytes ready for readData()
+    qint64 m_bufferedBytes;
+    bool m_firstBytesRead;
+    QElapsedTimer m_servingTimer;   // since the first byte was read
+    QElapsedTimer m_stallTimer;     // valid while the reader waits on a piece
+};
+#endif // TORRENT_SUPPORT_ENABLED
+
+#endif // TORRENT_PIECE_STREAM_H
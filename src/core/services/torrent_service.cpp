@@ -1,7 +1,10 @@
 #include "torrent_service.h"
 #include "torrent_stream_server.h"
 #include "logging_service.h"
+#include "configuration.h"
+#include "core/di/service_registry.h"
 #include <QUrl>
+#include <QUrlQuery>
 #include <QRegularExpression>
 
 TorrentService::TorrentService(QObject* parent)
@@ -13,6 +16,25 @@ TorrentService::TorrentService(QObject* parent)
     m_available = true;
     m_streamServer = new TorrentStreamServer(this);
     
+    auto config = ServiceRegistry::instance().resolve<Configuration>();
+    if (config) {
+        m_streamServer->setReadAheadSettings(config->torrentReadAheadSeconds(),
+                                             config->torrentAssumedBitrate());
+        m_streamServer->setStatusInterval(config->torrentStatusIntervalMs());
+        m_streamServer->setCacheSettings(config->torrentCacheDirectory(),
+                                         config->torrentCacheLimitBytes());
+        m_streamServer->setMetadataCacheDirectory(config->torrentMetadataDirectory());
+        m_streamServer->setSessionProfile(config->torrentSessionProfile());
+        m_streamServer->setIdlePolicy(config->torrentIdlePauseSeconds(),
+                                      config->torrentIdleRemoveMinutes(),
+                                      config->torrentMaxActive());
+        // Chosen in the settings screen; applies to the running session
+        Configuration* configuration = config.get();
+        connect(configuration, &Configuration::torrentSessionProfileChanged, this, [this, configuration]() {
+            m_streamServer->setSessionProfile(configuration->torrentSessionProfile());
+        });
+    }
+    
     // Start the streaming server
     if (m_streamServer->startServer(0)) {
         LoggingService::logInfo("TorrentService", 
@@ -26,6 +48,8 @@ TorrentService::TorrentService(QObject* parent)
                 });
         connect(m_streamServer, &TorrentStreamServer::progressChanged, 
                 this, &TorrentService::progressChanged);
+        connect(m_streamServer, &TorrentStreamServer::bufferHealthChanged, 
+                this, &TorrentService::bufferHealthChanged);
     } else {
         LoggingService::logError("TorrentService", "Failed to start torrent streaming server");
         m_available = false;
@@ -56,6 +80,10 @@ QString TorrentService::getStreamUrl(const QString& magnetLinkOrHash, int fileIn
         return QString();
     }
 
+    if (fileIndex < 0) {
+        fileIndex = fileIndexFromMagnet(normalized);
+    }
+
     QString streamUrl = m_streamServer->addMagnetLink(normalized, fileIndex);
     if (!streamUrl.isEmpty()) {
         LoggingService::logInfo("TorrentService", 
@@ -67,6 +95,15 @@ QString TorrentService::getStreamUrl(const QString& magnetLinkOrHash, int fileIn
     return streamUrl;
 }
 
+QString TorrentService::magnetDescriptor(const QString& magnetLinkOrHash, int fileIndex) const
+{
+    QString normalized = normalizeMagnetLink(magnetLinkOrHash);
+    if (normalized.isEmpty() || fileIndex < 0 || fileIndexFromMagnet(normalized) >= 0) {
+        return normalized;
+    }
+    return QString("%1&so=%2").arg(normalized).arg(fileIndex);
+}
+
 bool TorrentService::isMagnetLink(const QString& url) const
 {
     if (url.startsWith("magnet:", Qt::CaseInsensitive)) {
@@ -106,6 +143,46 @@ bool TorrentService::isReady(const QString& streamUrl) const
     return m_streamServer->isReady(streamUrl);
 }
 
+void TorrentService::setPlaybackDuration(const QString& streamUrl, qint64 durationMs)
+{
+    if (!m_available || !m_streamServer) {
+        return;
+    }
+    m_streamServer->setStreamDuration(streamUrl, durationMs);
+}
+
+bool TorrentService::setSessionProfile(const QString& profile)
+{
+    if (!m_available || !m_streamServer) {
+        return false;
+    }
+    return m_streamServer->setSessionProfile(profile);
+}
+
+void TorrentService::saveResumeData(const QString& streamUrl)
+{
+    if (!m_available || !m_streamServer) {
+        return;
+    }
+    m_streamServer->saveResumeData(streamUrl);
+}
+
+QVariantMap TorrentService::getBufferHealth(const QString& streamUrl) const
+{
+    if (!m_available || !m_streamServer) {
+        return QVariantMap();
+    }
+    return m_streamServer->getBufferHealth(streamUrl);
+}
+
+QVariantMap TorrentService::getFirstByteLatencyStats() const
+{
+    if (!m_available || !m_streamServer) {
+        return QVariantMap();
+    }
+    return m_streamServer->getFirstByteLatencyStats();
+}
+
 void TorrentService::removeTorrent(const QString& streamUrl)
 {
     if (!m_available || !m_streamServer) {
@@ -114,6 +191,15 @@ void TorrentService::removeTorrent(const QString& streamUrl)
     m_streamServer->removeTorrent(streamUrl);
 }
 
+int TorrentService::fileIndexFromMagnet(const QString& magnetLink)
+{
+    // Only a single "select only" index identifies the file to stream
+    QString selectOnly = QUrlQuery(QUrl(magnetLink)).queryItemValue("so");
+    bool ok = false;
+    int fileIndex = selectOnly.toInt(&ok);
+    return ok && fileIndex >= 0 ? fileIndex : -1;
+}
+
 QString TorrentService::normalizeMagnetLink(const QString& input) const
 {
     QString trimmed = input.trimmed();
@@ -4,6 +4,7 @@
 #include <QObject>
 #include <QString>
 #include <QUrl>
+#include <QVariantMap>
 #include <QtQmlIntegration/qqmlintegration.h>
 
 class TorrentStreamServer;
@@ -36,6 +37,14 @@ public:
      */
     Q_INVOKABLE QString getStreamUrl(const QString& magnetLinkOrHash, int fileIndex = -1);
 
+    /**
+     * @brief Build an unresolved magnet descriptor for a stream list entry
+     * @param magnetLinkOrHash Magnet link or infoHash
+     * @param fileIndex File to play, kept as the BEP 53 "so" parameter (-1 = auto-detect)
+     * @return Magnet link that getStreamUrl() can activate later
+     */
+    Q_INVOKABLE QString magnetDescriptor(const QString& magnetLinkOrHash, int fileIndex = -1) const;
+
     /**
      * @brief Check if a URL is a magnet link or infoHash
      */
@@ -56,6 +65,31 @@ public:
      */
     Q_INVOKABLE bool isReady(const QString& streamUrl) const;
 
+    /**
+     * @brief Report the playback duration of a stream so read-ahead matches its bitrate
+     */
+    Q_INVOKABLE void setPlaybackDuration(const QString& streamUrl, qint64 durationMs);
+
+    /**
+     * @brief Switch the torrent session profile ("streaming", "balanced" or "low-resource")
+     */
+    Q_INVOKABLE bool setSessionProfile(const QString& profile);
+
+    /**
+     * @brief Persist a stream's download progress so it resumes in a later session
+     */
+    Q_INVOKABLE void saveResumeData(const QString& streamUrl);
+
+    /**
+     * @brief Buffering state of a stream (bytes ahead of the play head, peers, availability)
+     */
+    Q_INVOKABLE QVariantMap getBufferHealth(const QString& streamUrl) const;
+
+    /**
+     * @brief Time-to-first-byte, throughput and stall statistics of the local stream server
+     */
+    Q_INVOKABLE QVariantMap getFirstByteLatencyStats() const;
+
     /**
      * @brief Stop and remove a torrent
      */
@@ -65,9 +99,11 @@ signals:
     void streamReady(const QString& streamUrl);
     void streamError(const QString& streamUrl, const QString& error);
     void progressChanged(const QString& streamUrl, double progress);
+    void bufferHealthChanged(const QString& streamUrl, const QVariantMap& health);
 
 private:
     QString normalizeMagnetLink(const QString& input) const;
+    static int fileIndexFromMagnet(const QString& magnetLink);
     bool m_available;
     TorrentStreamServer* m_streamServer;
 };
@@ -0,0 +1,403 @@
+#include "torrent_stream_scheduler.h"
+
+#ifdef TORRENT_SUPPORT_ENABLED
+#include <libtorrent/torrent_info.hpp>
+#include <libtorrent/download_priority.hpp>
+#include <utility>
+#include <vector>
+
+namespace {
+// Upper bound on the deadline of pinned startup pieces (milliseconds)
+constexpr qint64 kPinnedDeadlineMs = 1000;
+// Longest deadline handed to libtorrent (milliseconds)
+constexpr qint64 kMaxDeadlineMs = 24 * 60 * 60 * 1000;
+// A piece's deadline is only moved when it gets at least this much earlier, so
+// absolute due times stay put while readers advance (milliseconds)
+constexpr qint64 kDeadlineSlackMs = 250;
+}
+
+TorrentStreamScheduler::TorrentStreamScheduler(const libtorrent::torrent_handle& handle,
+                                               qint64 fileStart, qint64 fileEnd,
+                                               const Settings& settings)
+    : m_handle(handle)
+    , m_settings(settings)
+    , m_bitrate(qMax<qint64>(1, settings.bitrate))
+    , m_pieceLength(1)
+    , m_firstPiece(0)
+    , m_lastPiece(-1)
+    , m_nextCursorId(1)
+    , m_playhead(fileStart)
+    , m_lowWaterPiece(0)
+    , m_fileStart(fileStart)
+    , m_fileEnd(fileEnd)
+{
+    auto ti = m_handle.torrent_file();
+    if (ti) {
+        m_pieceLength = ti->piece_length();
+    }
+    m_firstPiece = pieceAt(fileStart);
+    m_lastPiece = pieceAt(fileEnd - 1);
+    m_lowWaterPiece = m_firstPiece;
+    m_onDisk.resize(qMax(0, m_lastPiece - m_firstPiece + 1));
+    m_clock.start();
+}
+
+void TorrentStreamScheduler::setSettings(const Settings& settings)
+{
+    if (m_bitrate == m_settings.bitrate) {
+        m_bitrate = qMax<qint64>(1, settings.bitrate);
+    }
+    m_settings = settings;
+    updateDeadlines(true);
+}
+
+void TorrentStreamScheduler::setBitrate(qint64 bytesPerSecond)
+{
+    if (bytesPerSecond <= 0 || bytesPerSecond == m_bitrate) {
+        return;
+    }
+    m_bitrate = bytesPerSecond;
+    updateDeadlines(true);
+}
+
+int TorrentStreamScheduler::pieceAt(qint64 offset) const
+{
+    return static_cast<int>(offset / m_pieceLength);
+}
+
+int TorrentStreamScheduler::windowPieces() const
+{
+    qint64 bytes = qBound(m_settings.minWindowBytes,
+                          static_cast<qint64>(m_settings.readAheadSeconds) * m_bitrate,
+                          m_settings.maxWindowBytes);
+    return static_cast<int>(qMax<qint64>(1, (bytes + m_pieceLength - 1) / m_pieceLength));
+}
+
+qint64 TorrentStreamScheduler::pieceTimeMs(int distance) const
+{
+    // Time until playback covers distance pieces at the current bitrate
+    return static_cast<qint64>(qMax(0, distance)) * m_pieceLength * 1000 / m_bitrate;
+}
+
+const TorrentStreamScheduler::Cursor* TorrentStreamScheduler::primaryCursor() const
+{
+    // The reader that has consumed the most is the player's demuxer; probes
+    // and thumbnailers read a little and go away
+    const Cursor* primary = nullptr;
+    int primaryId = 0;
+    for (auto it = m_cursors.cbegin(); it != m_cursors.cend(); ++it) {
+        qint64 consumed = it->offset - it->start;
+        if (!primary || consumed > primary->offset - primary->start
+            || (consumed == primary->offset - primary->start && it.key() < primaryId)) {
+            primary = &it.value();
+            primaryId = it.key();
+        }
+    }
+    return primary;
+}
+
+bool TorrentStreamScheduler::isFinished(int piece) const
+{
+    return isOnDisk(piece) || m_unflushedPieces.contains(piece);
+}
+
+qint64 TorrentStreamScheduler::dueFor(int piece, qint64 now) const
+{
+    // The nearest reader at or before the piece reaches it first
+    int nearestHead = -1;
+    for (const Cursor& cursor : m_cursors) {
+        if (cursor.headPiece <= piece) {
+            nearestHead = qMax(nearestHead, cursor.headPiece);
+        }
+    }
+    qint64 deadlineMs = nearestHead < 0 ? 0 : pieceTimeMs(piece - nearestHead);
+    if (m_pinnedPieces.contains(piece)) {
+        // Startup pieces are needed before playback can begin at all
+        deadlineMs = qMin(deadlineMs, kPinnedDeadlineMs);
+    }
+    return now + qMin(deadlineMs, kMaxDeadlineMs);
+}
+
+void TorrentStreamScheduler::setDeadline(int piece, qint64 dueMs)
+{
+    // set_piece_deadline replaces the flags of an existing deadline, so pieces
+    // a reader waits on must always keep alert_when_available
+    libtorrent::deadline_flags_t flags = m_alertPieces.contains(piece)
+        ? libtorrent::torrent_handle::alert_when_available
+        : libtorrent::deadline_flags_t{};
+    qint64 remainingMs = qBound<qint64>(0, dueMs - m_clock.elapsed(), kMaxDeadlineMs);
+    m_handle.set_piece_deadline(libtorrent::piece_index_t(piece), static_cast<int>(remainingMs), flags);
+    m_deadlines.insert(piece, dueMs);
+}
+
+int TorrentStreamScheduler::openCursor(qint64 offset)
+{
+    Cursor cursor;
+    cursor.start = offset;
+    cursor.offset = offset;
+    cursor.headPiece = qBound(m_firstPiece, pieceAt(offset), qMax(m_firstPiece, m_lastPiece));
+    int id = m_nextCursorId++;
+    m_cursors.insert(id, cursor);
+    updateDeadlines(false);
+    return id;
+}
+
+void TorrentStreamScheduler::advanceCursor(int cursor, qint64 offset)
+{
+    auto it = m_cursors.find(cursor);
+    if (it == m_cursors.end() || offset <= it->offset) {
+        return;
+    }
+    it->offset = offset;
+    if (const Cursor* primary = primaryCursor()) {
+        m_playhead = primary->offset;
+    }
+
+    int newHead = qMin(pieceAt(offset), m_lastPiece);
+    if (newHead > it->headPiece) {
+        it->headPiece = newHead;
+        updateDeadlines(false);
+    }
+}
+
+void TorrentStreamScheduler::closeCursor(int cursor)
+{
+    if (m_cursors.remove(cursor) > 0) {
+        updateDeadlines(false);
+    }
+}
+
+void TorrentStreamScheduler::requestPiece(int piece)
+{
+    // alert_when_available also covers pieces already on disk: libtorrent
+    // posts the read_piece_alert right away for those
+    ++m_alertPieces[piece];
+    auto it = m_deadlines.constFind(piece);
+    setDeadline(piece, it != m_deadlines.cend() ? it.value() : dueFor(piece, m_clock.elapsed()));
+}
+
+void TorrentStreamScheduler::releasePiece(int piece)
+{
+    auto it = m_alertPieces.find(piece);
+    if (it != m_alertPieces.end() && --it.value() <= 0) {
+        m_alertPieces.erase(it);
+    }
+}
+
+void TorrentStreamScheduler::onPieceRead(int piece)
+{
+    // One alert is dispatched to every reader waiting on the piece
+    m_alertPieces.remove(piece);
+    m_deadlines.remove(piece);
+}
+
+bool TorrentStreamScheduler::prefetchStartup(
+    const libtorrent::typed_bitfield<libtorrent::piece_index_t>& havePieces)
+{
+    m_pinnedPieces.clear();
+    if (m_lastPiece < m_firstPiece) {
+        return true;
+    }
+
+    // Header plus the first seconds of payload, then the tail where MP4 keeps
+    // its moov atom and MKV its cues
+    qint64 headBytes = m_settings.startupHeadBytes
+        + static_cast<qint64>(m_settings.startupSeconds) * m_bitrate;
+    int headEnd = qMin(m_lastPiece, pieceAt(qMin(m_fileEnd - 1, m_fileStart + headBytes)));
+    int tailStart = qMax(m_firstPiece, pieceAt(qMax(m_fileStart, m_fileEnd - m_settings.startupTailBytes)));
+
+    auto pin = [this, &havePieces](int piece) {
+        bool have = !havePieces.empty() && havePieces.get_bit(libtorrent::piece_index_t(piece));
+        if (!have) {
+            m_pinnedPieces.insert(piece);
+        }
+    };
+    for (int piece = m_firstPiece; piece <= headEnd; ++piece) {
+        pin(piece);
+    }
+    for (int piece = qMax(tailStart, headEnd + 1); piece <= m_lastPiece; ++piece) {
+        pin(piece);
+    }
+
+    if (m_pinnedPieces.isEmpty()) {
+        return true;
+    }
+
+    updateDeadlines(false);
+    return false;
+}
+
+bool TorrentStreamScheduler::onPieceFinished(int piece)
+{
+    if (piece >= m_firstPiece && piece <= m_lastPiece) {
+        // Finished is not written: libtorrent hashes from its write cache (1.2) or
+        // store buffer (2.x) before the write job completes, and reading the file
+        // then returns the zeros of a sparse file. Such pieces go through read_piece
+        // until a flush (save_resume_data with flush_disk_cache) confirms them
+        m_unflushedPieces.insert(piece);
+    }
+    // libtorrent drops the deadline of a finished piece by itself
+    if (!m_alertPieces.contains(piece)) {
+        m_deadlines.remove(piece);
+    }
+    return m_pinnedPieces.remove(piece) && m_pinnedPieces.isEmpty();
+}
+
+void TorrentStreamScheduler::setPiecesOnDisk(
+    const libtorrent::typed_bitfield<libtorrent::piece_index_t>& havePieces)
+{
+    if (havePieces.empty()) {
+        return;
+    }
+    for (int piece = m_firstPiece; piece <= m_lastPiece; ++piece) {
+        if (havePieces.get_bit(libtorrent::piece_index_t(piece))) {
+            m_onDisk.setBit(piece - m_firstPiece);
+        }
+    }
+}
+
+void TorrentStreamScheduler::onCacheFlushed()
+{
+    for (int piece : std::as_const(m_unflushedPieces)) {
+        m_onDisk.setBit(piece - m_firstPiece);
+    }
+    m_unflushedPieces.clear();
+}
+
+bool TorrentStreamScheduler::isOnDisk(int piece) const
+{
+    return piece >= m_firstPiece && piece <= m_lastPiece && m_onDisk.testBit(piece - m_firstPiece);
+}
+
+qint64 TorrentStreamScheduler::playhead() const
+{
+    const Cursor* primary = primaryCursor();
+    return primary ? primary->offset : m_playhead;
+}
+
+qint64 TorrentStreamScheduler::bufferedAhead(
+    const libtorrent::typed_bitfield<libtorrent::piece_index_t>& havePieces) const
+{
+    if (havePieces.empty() || m_lastPiece < m_firstPiece) {
+        return 0;
+    }
+    qint64 head = playhead();
+    int piece = qBound(m_firstPiece, pieceAt(head), m_lastPiece);
+    while (piece <= m_lastPiece && havePieces.get_bit(libtorrent::piece_index_t(piece))) {
+        ++piece;
+    }
+    qint64 contiguousEnd = qMin(m_fileEnd, static_cast<qint64>(piece) * m_pieceLength);
+    return qMax<qint64>(0, contiguousEnd - head);
+}
+
+double TorrentStreamScheduler::windowCompletion(
+    const libtorrent::typed_bitfield<libtorrent::piece_index_t>& havePieces) const
+{
+    if (havePieces.empty() || m_lastPiece < m_firstPiece) {
+        return 0.0;
+    }
+    int headPiece = qBound(m_firstPiece, pieceAt(playhead()), m_lastPiece);
+    int windowEnd = qMin(m_lastPiece + 1, headPiece + windowPieces());
+    int have = 0;
+    for (int piece = headPiece; piece < windowEnd; ++piece) {
+        if (havePieces.get_bit(libtorrent::piece_index_t(piece))) {
+            ++have;
+        }
+    }
+    return static_cast<double>(have) / (windowEnd - headPiece);
+}
+
+void TorrentStreamScheduler::updateDeadlines(bool force)
+{
+    if (!m_handle.is_valid() || m_lastPiece < m_firstPiece) {
+        return;
+    }
+
+    if (force) {
+        // Bitrate or window changed: every due time is stale
+        m_handle.clear_piece_deadlines();
+        m_deadlines.clear();
+    }
+
+    // Union of every cursor's window, plus pieces readers wait on and pinned
+    // startup pieces
+    QSet<int> wanted;
+    int window = windowPieces();
+    for (const Cursor& cursor : std::as_const(m_cursors)) {
+        int windowEnd = qMin(m_lastPiece + 1, cursor.headPiece + window);
+        for (int piece = cursor.headPiece; piece < windowEnd; ++piece) {
+            if (!isFinished(piece)) {
+                wanted.insert(piece);
+            }
+        }
+    }
+    for (auto it = m_alertPieces.cbegin(); it != m_alertPieces.cend(); ++it) {
+        wanted.insert(it.key());
+    }
+    for (int piece : std::as_const(m_pinnedPieces)) {
+        wanted.insert(piece);
+    }
+
+    // Overlapping windows share a piece at the earliest due time; deadlines
+    // only ever move earlier, so advancing readers cause no churn
+    qint64 now = m_clock.elapsed();
+    for (int piece : std::as_const(wanted)) {
+        qint64 due = dueFor(piece, now);
+        auto current = m_deadlines.constFind(piece);
+        if (current == m_deadlines.cend() || due < current.value() - kDeadlineSlackMs) {
+            setDeadline(piece, due);
+        }
+    }
+
+    // Drop deadlines no reader needs any more (closed cursors, seeks)
+    for (auto it = m_deadlines.begin(); it != m_deadlines.end();) {
+        if (!wanted.contains(it.key())) {
+            m_handle.reset_piece_deadline(libtorrent::piece_index_t(it.key()));
+            it = m_deadlines.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    if (!m_cursors.isEmpty()) {
+        int minHead = m_lastPiece;
+        for (const Cursor& cursor : std::as_const(m_cursors)) {
+            minHead = qMin(minHead, cursor.headPiece);
+        }
+        lowerPiecesBehind(minHead);
+    }
+}
+
+void TorrentStreamScheduler::lowerPiecesBehind(int piece)
+{
+    std::vector<std::pair<libtorrent::piece_index_t, libtorrent::download_priority_t>> changed;
+    if (piece > m_lowWaterPiece) {
+        // Pieces behind every reader no longer need bandwidth
+        for (int behind = m_lowWaterPiece; behind < piece; ++behind) {
+            if (m_alertPieces.contains(behind) || m_pinnedPieces.contains(behind) || isFinished(behind)) {
+                continue;
+            }
+            changed.emplace_back(libtorrent::piece_index_t(behind), libtorrent::low_priority);
+            m_loweredPieces.insert(behind);
+        }
+    } else if (piece < m_lowWaterPiece) {
+        // A reader went back (seek, new connection): what it will read again
+        // gets its normal priority back, not only the part inside its window
+        for (auto it = m_loweredPieces.begin(); it != m_loweredPieces.end();) {
+            if (*it < piece) {
+                ++it;
+                continue;
+            }
+            if (!isFinished(*it)) {
+                changed.emplace_back(libtorrent::piece_index_t(*it), libtorrent::default_priority);
+            }
+            it = m_loweredPieces.erase(it);
+        }
+    }
+    if (!changed.empty()) {
+        m_handle.prioritize_pieces(changed);
+    }
+    // Follows the slowest reader back after a seek, so those pieces are lowered again later
+    m_lowWaterPiece = piece;
+}
+#endif // TORRENT_SUPPORT_ENABLED
@@ -0,0 +1,176 @@
+#ifndef TORRENT_STREAM_SCHEDULER_H
+#define TORRENT_STREAM_SCHEDULER_H
+
+#include <QtGlobal>
+#include <QHash>
+#include <QSet>
+#include <QBitArray>
+#include <QElapsedTimer>
+
+#ifdef TORRENT_SUPPORT_ENABLED
+#include <libtorrent/torrent_handle.hpp>
+#include <libtorrent/bitfield.hpp>
+
+/**
+ * @brief Sliding-window piece deadline scheduler for one streamed torrent file
+ *
+ * Every HTTP connection reading the file owns a cursor. Each cursor keeps a
+ * read-ahead window of graded deadlines in front of its position: a piece's
+ * deadline is the time at which that reader is expected to reach it at the
+ * current bitrate estimate. The windows of all cursors are merged, so readers
+ * at overlapping offsets (the demuxer and a subtitle or thumbnail probe, or a
+ * reconnect) share piece fetches: a piece wanted by several cursors keeps the
+ * earliest deadline any of them needs. Pieces behind every cursor lose their
+ * deadline and drop to low priority until a reader moves back behind them.
+ *
+ * For startup, the head of the file (container header plus the first seconds of
+ * payload) and its tail (MP4 moov atom, MKV cues) can be pinned: pinned pieces
+ * keep short deadlines across seeks until they have been downloaded.
+ *
+ * All offsets are absolute offsets in the torrent's concatenated file space.
+ */
+class TorrentStreamScheduler
+{
+public:
+    struct Settings {
+        int readAheadSeconds = 30;
+        qint64 bitrate = 2500000;           // bytes per second, used until a hint arrives
+        qint64 minWindowBytes = 8 * 1024 * 1024;
+        qint64 maxWindowBytes = 512 * 1024 * 1024;
+        qint64 startupHeadBytes = 4 * 1024 * 1024;
+        int startupSeconds = 5;
+        qint64 startupTailBytes = 8 * 1024 * 1024;
+    };
+
+    TorrentStreamScheduler(const libtorrent::torrent_handle& handle,
+                           qint64 fileStart, qint64 fileEnd,
+                           const Settings& settings);
+
+    void setSettings(const Settings& settings);
+    const Settings& settings() const { return m_settings; }
+
+    /**
+     * @brief Set the bitrate of the streamed file (bytes per second)
+     */
+    void setBitrate(qint64 bytesPerSecond);
+    qint64 bitrate() const { return m_bitrate; }
+
+    /**
+     * @brief A new reader (HTTP connection) starts at offset
+     * @return Cursor id for advanceCursor() and closeCursor()
+     */
+    int openCursor(qint64 offset);
+
+    /**
+     * @brief The reader owning cursor has consumed everything before offset
+     */
+    void advanceCursor(int cursor, qint64 offset);
+
+    /**
+     * @brief The reader owning cursor went away; its window is released
+     */
+    void closeCursor(int cursor);
+
+    /**
+     * @brief Request a piece that a reader needs delivered as a read_piece_alert
+     */
+    void requestPiece(int piece);
+
+    /**
+     * @brief A reader that requested piece went away before it was delivered
+     */
+    void releasePiece(int piece);
+
+    /**
+     * @brief A read_piece_alert for piece has been dispatched
+     */
+    void onPieceRead(int piece);
+
+    /**
+     * @brief Pin the file's head and tail so playback can start before anything else
+     * @param havePieces Pieces the torrent already has (from torrent_status::pieces)
+     * @return True if every pinned piece is already present
+     */
+    bool prefetchStartup(const libtorrent::typed_bitfield<libtorrent::piece_index_t>& havePieces);
+
+    /**
+     * @brief A piece finished downloading
+     * @return True if this piece completed the pinned startup set
+     */
+    bool onPieceFinished(int piece);
+
+    bool startupComplete() const { return m_pinnedPieces.isEmpty(); }
+
+    /**
+     * @brief Record pieces already stored in the downloaded files (e.g. restored from resume data)
+     */
+    void setPiecesOnDisk(const libtorrent::typed_bitfield<libtorrent::piece_index_t>& havePieces);
+
+    /**
+     * @brief The torrent's disk cache was flushed; every finished piece is now in the file
+     */
+    void onCacheFlushed();
+
+    /**
+     * @brief Whether piece can be read directly from the downloaded file
+     */
+    bool isOnDisk(int piece) const;
+
+    /**
+     * @brief Bytes downloaded contiguously from the play head onwards
+     */
+    qint64 bufferedAhead(const libtorrent::typed_bitfield<libtorrent::piece_index_t>& havePieces) const;
+
+    /**
+     * @brief Fraction (0.0 to 1.0) of the play head's read-ahead window already downloaded
+     */
+    double windowCompletion(const libtorrent::typed_bitfield<libtorrent::piece_index_t>& havePieces) const;
+
+    /**
+     * @brief Position of the primary reader (the cursor that has consumed the most)
+     */
+    qint64 playhead() const;
+    int cursorCount() const { return m_cursors.size(); }
+    int pieceLength() const { return m_pieceLength; }
+
+private:
+    struct Cursor {
+        qint64 start = 0;
+        qint64 offset = 0;
+        int headPiece = 0;
+    };
+
+    int pieceAt(qint64 offset) const;
+    int windowPieces() const;
+    qint64 pieceTimeMs(int distance) const;
+    const Cursor* primaryCursor() const;
+    bool isFinished(int piece) const;
+    qint64 dueFor(int piece, qint64 now) const;
+    void setDeadline(int piece, qint64 dueMs);
+    void updateDeadlines(bool force);
+    void lowerPiecesBehind(int piece);
+
+    libtorrent::torrent_handle m_handle;
+    Settings m_settings;
+    qint64 m_bitrate;
+    int m_pieceLength;
+    int m_firstPiece;
+    int m_lastPiece;
+
+    QHash<int, Cursor> m_cursors;
+    int m_nextCursorId;
+    qint64 m_playhead;             // last position of the primary cursor
+    int m_lowWaterPiece;           // pieces before this were lowered to low priority
+    QSet<int> m_loweredPieces;     // lowered and not restored yet
+    QElapsedTimer m_clock;
+    QHash<int, qint64> m_deadlines; // piece -> due time (m_clock ms) set on the handle
+    QHash<int, int> m_alertPieces; // piece -> number of readers waiting on it
+    QSet<int> m_pinnedPieces;      // startup pieces not downloaded yet
+    QBitArray m_onDisk;            // indexed from m_firstPiece
+    QSet<int> m_unflushedPieces;   // finished, possibly still in libtorrent's write cache
+    qint64 m_fileStart;
+    qint64 m_fileEnd;
+};
+#endif // TORRENT_SUPPORT_ENABLED
+
+#endif // TORRENT_STREAM_SCHEDULER_H
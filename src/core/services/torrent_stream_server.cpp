@@ -1,4 +1,5 @@
 #include "torrent_stream_server.h"
+#include "torrent_piece_stream.h"
 #include "logging_service.h"
 #include <QTimer>
 #include <QUrl>
@@ -9,15 +10,22 @@
 #include <QMimeDatabase>
 #include <QMimeType>
 #include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QSaveFile>
+#include <QDateTime>
 #include <QHostAddress>
 #include <QTcpServer>
-#include <QThread>
+#include <QTcpSocket>
+#include <QElapsedTimer>
+#include <QVariantList>
 
 #ifdef TORRENT_SUPPORT_ENABLED
 #ifdef HAVE_QHTTPSERVER
 #include <QHttpServer>
 #include <QHttpServerRequest>
 #include <QHttpServerResponse>
+#include <QHttpServerResponder>
 #include <QHttpHeaders>
 #endif
 #include <libtorrent/session.hpp>
@@ -28,10 +36,17 @@
 #include <libtorrent/read_resume_data.hpp>
 #include <libtorrent/write_resume_data.hpp>
 #include <libtorrent/error_code.hpp>
+#include <libtorrent/download_priority.hpp>
+#include <libtorrent/version.hpp>
 // #include <libtorrent/hex.hpp> // Removed to prevent usage of deprecated/unlinked header
 #include <libtorrent/string_view.hpp>
 #include <algorithm>
+#include <chrono>
+#include <utility>
 #include <fstream>
+#include <functional>
+#include <memory>
+#include <vector>
 #endif
 
 TorrentStreamServer::TorrentStreamServer(QObject* parent)
@@ -39,35 +54,50 @@ TorrentStreamServer::TorrentStreamServer(QObject* parent)
     , m_port(0)
 #ifdef TORRENT_SUPPORT_ENABLED
     , m_alertTimer(nullptr)
+    , m_statusTimer(nullptr)
+    , m_reaperTimer(nullptr)
+    , m_subscribedTorrents(0)
+    , m_cacheDirectory(QDir::temp().absoluteFilePath("yantrium-torrents"))
+    , m_cacheLimitBytes(0)
+    , m_cacheScanned(false)
+    , m_connectionsPerTorrent(0)
+    , m_idlePauseMs(0)
+    , m_idleRemoveMs(0)
+    , m_maxActiveTorrents(0)
 #endif
 {
 #ifdef TORRENT_SUPPORT_ENABLED
     // Configure libtorrent session
-    libtorrent::settings_pack settings;
-    settings.set_int(libtorrent::settings_pack::alert_mask, 
-        libtorrent::alert::error_notification | 
-        libtorrent::alert::status_notification |
-        libtorrent::alert::torrent_log_notification);
-    settings.set_bool(libtorrent::settings_pack::enable_dht, true);
-    settings.set_bool(libtorrent::settings_pack::enable_lsd, true);
-    settings.set_bool(libtorrent::settings_pack::enable_natpmp, true);
-    settings.set_bool(libtorrent::settings_pack::enable_upnp, true);
-    settings.set_int(libtorrent::settings_pack::download_rate_limit, 0); // Unlimited
-    settings.set_int(libtorrent::settings_pack::upload_rate_limit, 0); // Unlimited
-    settings.set_int(libtorrent::settings_pack::active_downloads, 10);
-    settings.set_int(libtorrent::settings_pack::active_seeds, 10);
+    setSessionProfile("streaming");
     
-    m_session.apply_settings(settings);
+    // Process alerts as soon as libtorrent queues them. The notify callback runs
+    // on a libtorrent thread, so only post a queued call to our own thread.
+    m_session.set_alert_notify([this]() {
+        QMetaObject::invokeMethod(this, &TorrentStreamServer::onTorrentAlert, Qt::QueuedConnection);
+    });
     
-    // Set up alert processing timer
+    // Fallback alert processing timer
     m_alertTimer = new QTimer(this);
     connect(m_alertTimer, &QTimer::timeout, this, &TorrentStreamServer::onTorrentAlert);
     m_alertTimer->start(500); // Check alerts every 500ms
+    
+    // Status pump; only runs while some torrent has a stream attached
+    m_statusTimer = new QTimer(this);
+    m_statusTimer->setInterval(1000);
+    connect(m_statusTimer, &QTimer::timeout, this, &TorrentStreamServer::postStatusUpdates);
+    
+    // Idle reaper: pauses and removes torrents nobody is reading
+    m_reaperTimer = new QTimer(this);
+    m_reaperTimer->setInterval(kReaperIntervalMs);
+    connect(m_reaperTimer, &QTimer::timeout, this, &TorrentStreamServer::reapIdleTorrents);
 #endif
 }
 
 TorrentStreamServer::~TorrentStreamServer()
 {
+#ifdef TORRENT_SUPPORT_ENABLED
+    m_session.set_alert_notify(std::function<void()>());
+#endif
     stopServer();
 }
 
@@ -82,10 +112,26 @@ bool TorrentStreamServer::startServer(quint16 port)
     
     m_server = std::make_unique<QHttpServer>();
     
-    // Handle stream requests
-    m_server->route("/stream/<arg>", [this](const QString& /*streamId*/, const QHttpServerRequest& request) {
-        return handleRequest(request);
+    // Handle stream requests (responses are streamed, so handlers take the responder)
+    #if QT_VERSION >= QT_VERSION_CHECK(6, 8, 0)
+    m_server->route("/stream/<arg>", [this](const QString& streamId, const QHttpServerRequest& request,
+                                            QHttpServerResponder& responder) {
+        handleRequest(streamId, QString(), request, responder);
     });
+    m_server->route("/stream/<arg>/<arg>", [this](const QString& streamId, const QString& fileIndex,
+                                                  const QHttpServerRequest& request, QHttpServerResponder& responder) {
+        handleRequest(streamId, fileIndex, request, responder);
+    });
+    #else
+    m_server->route("/stream/<arg>", [this](const QString& streamId, const QHttpServerRequest& request,
+                                            QHttpServerResponder&& responder) {
+        handleRequest(streamId, QString(), request, responder);
+    });
+    m_server->route("/stream/<arg>/<arg>", [this](const QString& streamId, const QString& fileIndex,
+                                                  const QHttpServerRequest& request, QHttpServerResponder&& responder) {
+        handleRequest(streamId, fileIndex, request, responder);
+    });
+    #endif
     
     // Handle root requests (redirect to stream)
     m_server->route("/", [this](const QHttpServerRequest& /*request*/) {
@@ -118,6 +164,7 @@ bool TorrentStreamServer::startServer(quint16 port)
     m_port = m_server->serverPort();
     #endif
     m_baseUrl = QString("http://localhost:%1").arg(m_port);
+    m_reaperTimer->start();
     
     LoggingService::logInfo("TorrentStreamServer", 
         QString("HTTP server started on port %1").arg(m_port));
@@ -140,15 +187,31 @@ void TorrentStreamServer::stopServer()
     if (m_alertTimer) {
         m_alertTimer->stop();
     }
+    if (m_statusTimer) {
+        m_statusTimer->stop();
+    }
+    if (m_reaperTimer) {
+        m_reaperTimer->stop();
+    }
+    m_subscribedTorrents = 0;
     
-    // Remove all torrents
-    for (auto torrentIt = m_torrents.cbegin(); torrentIt != m_torrents.cend(); ++torrentIt) {
-        m_session.remove_torrent(torrentIt.value().handle);
+    // Persist progress so the next session resumes instead of re-downloading
+    saveAllResumeData();
+    
+    // Remove all torrents (downloaded data stays in the cache directory)
+    for (const auto& entry : m_torrents) {
+        m_session.remove_torrent(entry.second.handle);
     }
     m_torrents.clear();
-    m_streamUrlToMagnet.clear();
+    m_streamUrlIndex.clear();
+    m_streamIdIndex.clear();
+    m_retiredTorrents.clear();
+    m_pendingResumeIds.clear();
+    m_cachedTorrents.clear();
+    m_cacheScanned = false;
     
 #ifdef HAVE_QHTTPSERVER
+    failParkedRequests(libtorrent::torrent_handle());
     if (m_server) {
         m_server.reset();
     }
@@ -184,10 +247,53 @@ QString TorrentStreamServer::addMagnetLink(const QString& magnetLink, int fileIn
         return QString();
     }
     
-    // Set save path (we'll stream from memory, but need a temp path)
-    QString tempPath = QDir::temp().absoluteFilePath("yantrium-torrents");
-    QDir().mkpath(tempPath);
-    params.save_path = tempPath.toStdString();
+    // Resume a torrent from an earlier session: metadata and the pieces
+    // already on disk are available immediately
+    QString cacheId = torrentIdFor(infoHashOf(params));
+    QFile resumeFile(resumeFilePath(cacheId));
+    if (resumeFile.open(QIODevice::ReadOnly)) {
+        QByteArray resumeBytes = resumeFile.readAll();
+        resumeFile.close();
+        libtorrent::error_code resumeError;
+        libtorrent::add_torrent_params resumed = libtorrent::read_resume_data(
+            libtorrent::span<char const>(resumeBytes.constData(), resumeBytes.size()), resumeError);
+        if (!resumeError) {
+            params = std::move(resumed);
+            LoggingService::logDebug("TorrentStreamServer",
+                QString("Resuming torrent %1 from cache").arg(cacheId));
+        } else {
+            LoggingService::logWarning("TorrentStreamServer",
+                QString("Ignoring unreadable resume data for %1: %2")
+                    .arg(cacheId, QString::fromStdString(resumeError.message())));
+        }
+    }
+    
+    // Metadata fetched in an earlier session (its resume data may have been
+    // evicted): the torrent has metadata as soon as it is added
+    if (!params.ti) {
+        params.ti = loadCachedMetadata(infoHashOf(params));
+        if (params.ti) {
+            // Only the streamed file is wanted, so no request goes to the others
+            int streamFile = selectStreamFile(*params.ti, fileIndex);
+            if (streamFile < params.ti->num_files() && params.file_priorities.empty()) {
+                params.file_priorities.assign(static_cast<size_t>(params.ti->num_files()),
+                                              libtorrent::dont_download);
+                params.file_priorities[static_cast<size_t>(streamFile)] = libtorrent::default_priority;
+            }
+            LoggingService::logDebug("TorrentStreamServer",
+                QString("Using cached metadata for %1").arg(cacheId));
+        }
+    }
+    
+    // Each torrent downloads into its own cache subdirectory
+    QString savePath = QDir(m_cacheDirectory).absoluteFilePath(cacheId);
+    QDir().mkpath(savePath);
+    params.save_path = savePath.toStdString();
+    // Adding a torrent the session already has returns its existing handle
+    params.flags &= ~libtorrent::torrent_flags::duplicate_is_error;
+    // Subscribed to status updates only once a stream is attached
+    params.flags &= ~libtorrent::torrent_flags::update_subscribe;
+    params.max_connections = m_connectionsPerTorrent;
     
     // Add torrent to session
     libtorrent::torrent_handle handle = m_session.add_torrent(params, ec);
@@ -198,27 +304,56 @@ QString TorrentStreamServer::addMagnetLink(const QString& magnetLink, int fileIn
     }
     
     // Generate stream URL
-    libtorrent::sha1_hash hash = handle.info_hash();
-    // FIX: Replaced libtorrent::to_hex with Qt's native hex conversion to avoid LNK2019
-    QString torrentId = QByteArray::fromStdString(hash.to_string()).toHex();
+    libtorrent::sha1_hash hash = infoHashOf(handle);
+    auto existing = m_torrents.find(hash);
+    if (existing != m_torrents.end()) {
+        // Another file (or the same one) of a torrent we already have
+        TorrentInfo& info = existing->second;
+        info.idleSince.start();
+        if (info.paused) {
+            resumeTorrent(info);
+            enforceActiveLimit(&info);
+        }
+        QString streamUrl = m_baseUrl + generateStreamPath(info.torrentId, fileIndex);
+        if (!m_streamUrlIndex.contains(streamUrl)) {
+            info.streamUrls.append(streamUrl);
+            m_streamUrlIndex.insert(streamUrl, hash);
+        }
+        return streamUrl;
+    }
+    
+    // Named after the magnet's hash, which is what the next session looks its
+    // resume data up by
+    QString torrentId = cacheId;
     QString streamPath = generateStreamPath(torrentId, fileIndex);
     QString streamUrl = m_baseUrl + streamPath;
     
     // Store torrent info
     TorrentInfo info;
     info.handle = handle;
+    info.torrentId = torrentId;
     info.magnetLink = magnetLink;
+    info.savePath = savePath;
     info.fileIndex = fileIndex;
     info.isReady = false;
     info.progress = 0.0;
     info.downloadSpeed = 0;
+    info.streamUrl = streamUrl;
+    info.streamUrls.append(streamUrl);
+    info.idleSince.start();
+    // Pieces kept from an earlier session count until the first status update
+    info.diskBytes = m_cachedTorrents.take(torrentId).bytes;
     
-    m_torrents[streamUrl] = info;
-    m_streamUrlToMagnet[streamUrl] = magnetLink;
+    auto inserted = m_torrents.emplace(hash, std::move(info)).first;
+    m_streamUrlIndex.insert(streamUrl, hash);
+    m_streamIdIndex.insert(torrentId, hash);
+    m_retiredTorrents.remove(torrentId);
     
     LoggingService::logInfo("TorrentStreamServer", 
         QString("Added torrent, stream URL: %1").arg(streamUrl));
     
+    enforceActiveLimit(&inserted->second);
+    enforceCacheLimit();
     emit torrentAdded(streamUrl);
     return streamUrl;
 #else
@@ -237,10 +372,9 @@ QString TorrentStreamServer::addMagnetLink(const QString& magnetLink, int fileIn
 void TorrentStreamServer::removeTorrent(const QString& streamUrl)
 {
 #ifdef TORRENT_SUPPORT_ENABLED
-    if (m_torrents.contains(streamUrl)) {
-        m_session.remove_torrent(m_torrents.value(streamUrl).handle);
-        m_torrents.remove(streamUrl);
-        m_streamUrlToMagnet.remove(streamUrl);
+    auto hashIt = m_streamUrlIndex.constFind(streamUrl);
+    if (hashIt != m_streamUrlIndex.cend()) {
+        eraseTorrent(hashIt.value());
         LoggingService::logInfo("TorrentStreamServer", 
             QString("Removed torrent: %1").arg(streamUrl));
     }
@@ -252,8 +386,8 @@ void TorrentStreamServer::removeTorrent(const QString& streamUrl)
 double TorrentStreamServer::getProgress(const QString& streamUrl) const
 {
 #ifdef TORRENT_SUPPORT_ENABLED
-    if (m_torrents.contains(streamUrl)) {
-        return m_torrents.value(streamUrl).progress;
+    if (const TorrentInfo* info = findTorrentByStreamUrl(streamUrl)) {
+        return info->progress;
     }
 #endif
     Q_UNUSED(streamUrl);
@@ -263,8 +397,8 @@ double TorrentStreamServer::getProgress(const QString& streamUrl) const
 qint64 TorrentStreamServer::getDownloadSpeed(const QString& streamUrl) const
 {
 #ifdef TORRENT_SUPPORT_ENABLED
-    if (m_torrents.contains(streamUrl)) {
-        return m_torrents.value(streamUrl).downloadSpeed;
+    if (const TorrentInfo* info = findTorrentByStreamUrl(streamUrl)) {
+        return info->downloadSpeed;
     }
 #endif
     Q_UNUSED(streamUrl);
@@ -274,14 +408,179 @@ qint64 TorrentStreamServer::getDownloadSpeed(const QString& streamUrl) const
 bool TorrentStreamServer::isReady(const QString& streamUrl) const
 {
 #ifdef TORRENT_SUPPORT_ENABLED
-    if (m_torrents.contains(streamUrl)) {
-        return m_torrents.value(streamUrl).isReady;
+    if (const TorrentInfo* info = findTorrentByStreamUrl(streamUrl)) {
+        return info->isReady;
     }
 #endif
     Q_UNUSED(streamUrl);
     return false;
 }
 
+void TorrentStreamServer::setReadAheadSettings(int readAheadSeconds, qint64 assumedBitrate)
+{
+#ifdef TORRENT_SUPPORT_ENABLED
+    m_schedulerSettings.readAheadSeconds = qMax(1, readAheadSeconds);
+    m_schedulerSettings.bitrate = qMax<qint64>(1, assumedBitrate);
+    for (auto& entry : m_torrents) {
+        for (const auto& scheduler : std::as_const(entry.second.fileSchedulers)) {
+            scheduler->setSettings(m_schedulerSettings);
+        }
+    }
+#else
+    Q_UNUSED(readAheadSeconds);
+    Q_UNUSED(assumedBitrate);
+#endif
+}
+
+void TorrentStreamServer::setStreamDuration(const QString& streamUrl, qint64 durationMs)
+{
+#ifdef TORRENT_SUPPORT_ENABLED
+    TorrentInfo* found = findTorrentByStreamUrl(streamUrl);
+    if (!found || durationMs <= 0) {
+        return;
+    }
+    TorrentInfo& info = *found;
+    info.durationMs = durationMs;
+    if (info.scheduler && info.scheduledFileIndex >= 0) {
+        auto ti = info.handle.torrent_file();
+        if (ti) {
+            qint64 fileSize = ti->files().file_size(libtorrent::file_index_t(info.scheduledFileIndex));
+            info.scheduler->setBitrate(fileSize * 1000 / durationMs);
+        }
+    }
+#else
+    Q_UNUSED(streamUrl);
+    Q_UNUSED(durationMs);
+#endif
+}
+
+bool TorrentStreamServer::setSessionProfile(const QString& profile)
+{
+#ifdef TORRENT_SUPPORT_ENABLED
+    libtorrent::settings_pack settings;
+    int connectionsPerTorrent = 0;
+    if (!profileSettings(profile, settings, connectionsPerTorrent)) {
+        LoggingService::logWarning("TorrentStreamServer",
+            QString("Unknown session profile: %1").arg(profile));
+        return false;
+    }
+    
+    // apply_settings only touches the keys in the pack, so this works on a live session
+    m_session.apply_settings(settings);
+    m_connectionsPerTorrent = connectionsPerTorrent;
+    for (const auto& entry : m_torrents) {
+        entry.second.handle.set_max_connections(m_connectionsPerTorrent);
+    }
+    
+    if (profile != m_sessionProfile) {
+        // Latency stats describe one profile at a time so profiles can be compared
+        m_sessionProfile = profile;
+        m_firstByteLatency = LatencyHistogram();
+        m_servingStats = ServingStats();
+        LoggingService::logInfo("TorrentStreamServer",
+            QString("Applied session profile: %1").arg(profile));
+    }
+    return true;
+#else
+    Q_UNUSED(profile);
+    return false;
+#endif
+}
+
+QString TorrentStreamServer::sessionProfile() const
+{
+#ifdef TORRENT_SUPPORT_ENABLED
+    return m_sessionProfile;
+#else
+    return QString();
+#endif
+}
+
+void TorrentStreamServer::setCacheSettings(const QString& directory, qint64 limitBytes)
+{
+#ifdef TORRENT_SUPPORT_ENABLED
+    if (!directory.isEmpty() && directory != m_cacheDirectory) {
+        m_cacheDirectory = directory;
+        QDir().mkpath(m_cacheDirectory);
+        m_cacheScanned = false;
+    }
+    m_cacheLimitBytes = qMax<qint64>(0, limitBytes);
+    enforceCacheLimit();
+#else
+    Q_UNUSED(directory);
+    Q_UNUSED(limitBytes);
+#endif
+}
+
+void TorrentStreamServer::setMetadataCacheDirectory(const QString& directory)
+{
+#ifdef TORRENT_SUPPORT_ENABLED
+    m_metadataDirectory = directory;
+    if (!m_metadataDirectory.isEmpty()) {
+        QDir().mkpath(m_metadataDirectory);
+    }
+#else
+    Q_UNUSED(directory);
+#endif
+}
+
+void TorrentStreamServer::setIdlePolicy(int pauseAfterSeconds, int removeAfterMinutes, int maxActiveTorrents)
+{
+#ifdef TORRENT_SUPPORT_ENABLED
+    m_idlePauseMs = qMax(0, pauseAfterSeconds) * 1000LL;
+    m_idleRemoveMs = qMax(0, removeAfterMinutes) * 60LL * 1000;
+    m_maxActiveTorrents = qMax(0, maxActiveTorrents);
+    enforceActiveLimit(nullptr);
+#else
+    Q_UNUSED(pauseAfterSeconds);
+    Q_UNUSED(removeAfterMinutes);
+    Q_UNUSED(maxActiveTorrents);
+#endif
+}
+
+void TorrentStreamServer::saveResumeData(const QString& streamUrl)
+{
+#ifdef TORRENT_SUPPORT_ENABLED
+    if (const TorrentInfo* info = findTorrentByStreamUrl(streamUrl)) {
+        requestResumeData(info->handle);
+    }
+#else
+    Q_UNUSED(streamUrl);
+#endif
+}
+
+void TorrentStreamServer::setStatusInterval(int intervalMs)
+{
+#ifdef TORRENT_SUPPORT_ENABLED
+    m_statusTimer->setInterval(qMax(100, intervalMs));
+#else
+    Q_UNUSED(intervalMs);
+#endif
+}
+
+QVariantMap TorrentStreamServer::getBufferHealth(const QString& streamUrl) const
+{
+#ifdef TORRENT_SUPPORT_ENABLED
+    if (const TorrentInfo* info = findTorrentByStreamUrl(streamUrl)) {
+        return bufferHealth(*info);
+    }
+#endif
+    Q_UNUSED(streamUrl);
+    return QVariantMap();
+}
+
+QVariantMap TorrentStreamServer::getFirstByteLatencyStats() const
+{
+#ifdef TORRENT_SUPPORT_ENABLED
+    QVariantMap stats = m_firstByteLatency.toVariantMap();
+    m_servingStats.addTo(stats);
+    stats["profile"] = m_sessionProfile;
+    return stats;
+#else
+    return QVariantMap();
+#endif
+}
+
 void TorrentStreamServer::onTorrentAlert()
 {
 #ifdef TORRENT_SUPPORT_ENABLED
@@ -296,337 +595,1188 @@ void TorrentStreamServer::processTorrentAlerts()
     m_session.pop_alerts(&alerts);
     
     for (libtorrent::alert* alert : alerts) {
+        if (handleResumeAlert(alert)) {
+            continue;
+        }
         if (auto* ta = libtorrent::alert_cast<libtorrent::add_torrent_alert>(alert)) {
-            // Torrent metadata downloaded
-            libtorrent::sha1_hash hash = ta->handle.info_hash();
-            // FIX: Replaced libtorrent::to_hex
-            QString torrentId = QByteArray::fromStdString(hash.to_string()).toHex();
-
-            // Find stream URL for this torrent
-            QString streamUrl;
-            for (auto torrentIt = m_torrents.cbegin(); torrentIt != m_torrents.cend(); ++torrentIt) {
-                if (torrentIt.value().handle.info_hash() == ta->handle.info_hash()) {
-                    streamUrl = torrentIt.key();
-                    break;
-                }
-            }
-
-            if (!streamUrl.isEmpty()) {
+            TorrentInfo* info = findTorrentByHandle(ta->handle);
+            if (info) {
                 LoggingService::logInfo("TorrentStreamServer",
-                    QString("Torrent metadata downloaded: %1").arg(streamUrl));
+                    QString("Torrent added: %1").arg(info->streamUrl));
+                // Torrents added with metadata never get a metadata_received_alert
+                if (auto ti = ta->handle.torrent_file()) {
+                    storeMetadata(info->torrentId, *ti);
+                    startStartupPrefetch(*info);
+                }
             }
         }
         else if (auto* sa = libtorrent::alert_cast<libtorrent::state_update_alert>(alert)) {
-            // Update torrent states
+            // Update every torrent state in one pass; signals go out afterwards so
+            // slots never run while the batch is half applied
+            QList<TorrentInfo*> updated;
+            QList<TorrentInfo*> progressed;
+            updated.reserve(static_cast<qsizetype>(sa->status.size()));
             for (const auto& status : sa->status) {
-                libtorrent::sha1_hash hash = status.handle.info_hash();
-                // FIX: Replaced libtorrent::to_hex
-                QString torrentId = QByteArray::fromStdString(hash.to_string()).toHex();
-
-                // Find stream URL
-                QString streamUrl;
-                for (auto it = m_torrents.begin(); it != m_torrents.end(); ++it) {
-                    if (it.value().handle.info_hash() == status.handle.info_hash()) {
-                        streamUrl = it.key();
-                        TorrentInfo& info = it.value();
-
-                        // Update progress
-                        double progress = status.progress;
-                        if (progress != info.progress) {
-                            info.progress = progress;
-                            emit progressChanged(streamUrl, progress);
-                        }
-
-                        // Update download speed
-                        info.downloadSpeed = status.download_payload_rate;
-
-                        // Check if ready (have enough pieces to start streaming)
-                        bool wasReady = info.isReady;
-                        info.isReady = (progress > 0.01); // 1% downloaded
-
-                        if (!wasReady && info.isReady) {
-                            emit torrentReady(streamUrl);
-                        }
-
-                        break;
+                TorrentInfo* info = findTorrentByHandle(status.handle);
+                if (!info) {
+                    continue;
+                }
+                info->downloadSpeed = status.download_payload_rate;
+                info->peers = status.num_peers;
+                info->seeds = status.num_seeds;
+                info->availability = status.distributed_copies;
+                info->diskBytes = status.total_done;
+                if (info->scheduler) {
+                    info->bufferedAheadBytes = info->scheduler->bufferedAhead(status.pieces);
+                    info->windowCompletion = info->scheduler->windowCompletion(status.pieces);
+                }
+                if (status.progress != info->progress) {
+                    info->progress = status.progress;
+                    progressed.append(info);
+                }
+                updated.append(info);
+                // Readiness is driven by the startup pieces (see startStartupPrefetch)
+            }
+            for (TorrentInfo* info : std::as_const(progressed)) {
+                emit progressChanged(info->streamUrl, info->progress);
+            }
+            for (TorrentInfo* info : std::as_const(updated)) {
+                emit bufferHealthChanged(info->streamUrl, bufferHealth(*info));
+            }
+        }
+        else if (auto* ma = libtorrent::alert_cast<libtorrent::metadata_received_alert>(alert)) {
+            TorrentInfo* info = findTorrentByHandle(ma->handle);
+            if (info) {
+                LoggingService::logInfo("TorrentStreamServer",
+                    QString("Torrent metadata downloaded: %1").arg(info->streamUrl));
+                if (auto ti = ma->handle.torrent_file()) {
+                    storeMetadata(info->torrentId, *ti);
+                }
+                startStartupPrefetch(*info);
+            }
+#ifdef HAVE_QHTTPSERVER
+            resumeParkedRequests(ma->handle);
+#endif
+        }
+        else if (auto* pfa = libtorrent::alert_cast<libtorrent::piece_finished_alert>(alert)) {
+            TorrentInfo* info = findTorrentByHandle(pfa->handle);
+            if (info) {
+                bool startupComplete = false;
+                for (const auto& scheduler : std::as_const(info->fileSchedulers)) {
+                    if (scheduler->onPieceFinished(static_cast<int>(pfa->piece_index))
+                        && scheduler == info->scheduler) {
+                        startupComplete = true;
                     }
                 }
+                if (startupComplete) {
+                    markReady(*info);
+                }
             }
         }
-        else if (auto* ea = libtorrent::alert_cast<libtorrent::torrent_error_alert>(alert)) {
-            libtorrent::sha1_hash hash = ea->handle.info_hash();
-            // FIX: Replaced libtorrent::to_hex
-            QString torrentId = QByteArray::fromStdString(hash.to_string()).toHex();
-            
-            QString streamUrl;
-            for (auto torrentIt = m_torrents.cbegin(); torrentIt != m_torrents.cend(); ++torrentIt) {
-                if (torrentIt.value().handle.info_hash() == ea->handle.info_hash()) {
-                    streamUrl = torrentIt.key();
-                    break;
+        else if (auto* rpa = libtorrent::alert_cast<libtorrent::read_piece_alert>(alert)) {
+            TorrentInfo* info = findTorrentByHandle(rpa->handle);
+            if (info) {
+                for (const auto& scheduler : std::as_const(info->fileSchedulers)) {
+                    scheduler->onPieceRead(static_cast<int>(rpa->piece));
+                }
+            }
+            // Hand piece data to every open stream reading this torrent
+            for (TorrentPieceStream* stream : std::as_const(m_streams)) {
+                if (stream->handle() == rpa->handle && stream->wantsPiece(rpa->piece)) {
+                    stream->onPieceRead(rpa->piece, rpa->buffer, rpa->size, rpa->error);
                 }
             }
-            
-            if (!streamUrl.isEmpty()) {
+        }
+        else if (auto* ea = libtorrent::alert_cast<libtorrent::torrent_error_alert>(alert)) {
+            TorrentInfo* info = findTorrentByHandle(ea->handle);
+            if (info) {
                 QString errorMsg = QString::fromStdString(ea->error.message());
                 LoggingService::logError("TorrentStreamServer", 
-                    QString("Torrent error: %1 - %2").arg(streamUrl, errorMsg));
-                emit torrentError(streamUrl, errorMsg);
+                    QString("Torrent error: %1 - %2").arg(info->streamUrl, errorMsg));
+                emit torrentError(info->streamUrl, errorMsg);
             }
         }
     }
 }
 
 #ifdef HAVE_QHTTPSERVER
-QHttpServerResponse TorrentStreamServer::handleRequest(const QHttpServerRequest& request)
+void TorrentStreamServer::handleRequest(const QString& torrentId, const QString& fileIndex,
+                                        const QHttpServerRequest& request, QHttpServerResponder& responder)
 {
-    QString path = request.url().path();
-    
-    // Extract torrent ID and file index from path
-    // Format: /stream/<torrentId>[/<fileIndex>]
-    QRegularExpression pathRegex("/stream/([^/]+)(?:/(\\d+))?");
-    QRegularExpressionMatch match = pathRegex.match(path);
+    StreamRequest streamRequest;
+    streamRequest.timer.start();
+    streamRequest.peerAddress = request.remoteAddress();
+    streamRequest.peerPort = request.remotePort();
     
-    if (!match.hasMatch()) {
-        return QHttpServerResponse(QHttpServerResponse::StatusCode::NotFound);
+    // Path format: /stream/<torrentId>[/<fileIndex>]; the router already split it
+    streamRequest.torrentId = torrentId;
+    if (!fileIndex.isEmpty()) {
+        bool ok = false;
+        streamRequest.fileIndex = fileIndex.toInt(&ok);
+        if (!ok || streamRequest.fileIndex < 0) {
+            responder.sendResponse(QHttpServerResponse(QHttpServerResponse::StatusCode::NotFound));
+            return;
+        }
     }
     
-    QString torrentId = match.captured(1);
-    int fileIndex = match.captured(2).toInt();
+    // Handle range requests for video streaming
+    QString rangeHeader = request.value("Range");
+    if (!rangeHeader.isEmpty()) {
+        // "bytes=N-", "bytes=N-M", or the suffix form "bytes=-N" players use to
+        // probe the MP4 moov atom or MKV cues at the end of the file
+        static const QRegularExpression rangeRegex("bytes=(\\d*)-(\\d*)");
+        QRegularExpressionMatch rangeMatch = rangeRegex.match(rangeHeader);
+        QString startStr = rangeMatch.captured(1);
+        QString endStr = rangeMatch.captured(2);
+        if (rangeMatch.hasMatch() && !startStr.isEmpty()) {
+            streamRequest.isRange = true;
+            streamRequest.start = startStr.toLongLong();
+            if (!endStr.isEmpty()) {
+                streamRequest.end = endStr.toLongLong();
+            }
+            if (streamRequest.end >= 0 && streamRequest.end < streamRequest.start) {
+                // Invalid spec such as "bytes=5-3": RFC 7233 says to ignore the
+                // header and send the whole file
+                streamRequest.isRange = false;
+                streamRequest.start = 0;
+                streamRequest.end = -1;
+            }
+        } else if (rangeMatch.hasMatch() && !endStr.isEmpty()) {
+            streamRequest.isRange = true;
+            streamRequest.suffixLength = endStr.toLongLong();
+        }
+    }
     
-    // Find torrent by ID
+    // Find torrent by ID; one the idle reaper removed is added back from its resume data
     libtorrent::torrent_handle handle;
-    TorrentInfo* info = nullptr;
-    
-    for (auto it = m_torrents.begin(); it != m_torrents.end(); ++it) {
-        libtorrent::sha1_hash hash = it.value().handle.info_hash();
-        // FIX: Replaced libtorrent::to_hex
-        QString id = QByteArray::fromStdString(hash.to_string()).toHex();
-        if (id == torrentId) {
-            handle = it.value().handle;
-            info = &it.value();
-            break;
+    auto hashIt = m_streamIdIndex.constFind(streamRequest.torrentId);
+    if (hashIt == m_streamIdIndex.cend() && reviveTorrent(streamRequest.torrentId)) {
+        hashIt = m_streamIdIndex.constFind(streamRequest.torrentId);
+    }
+    if (hashIt != m_streamIdIndex.cend()) {
+        auto it = m_torrents.find(hashIt.value());
+        if (it != m_torrents.end()) {
+            TorrentInfo& info = it->second;
+            handle = info.handle;
+            info.idleSince.start();
+            if (info.paused) {
+                resumeTorrent(info);
+                enforceActiveLimit(&info);
+            }
         }
     }
     
-    if (!handle.is_valid() || !info) {
-        return QHttpServerResponse(QHttpServerResponse::StatusCode::NotFound);
+    if (!handle.is_valid()) {
+        responder.sendResponse(QHttpServerResponse(QHttpServerResponse::StatusCode::NotFound));
+        return;
     }
     
-    // Get torrent status
-    libtorrent::torrent_status status = handle.status();
+    if (!handle.status().has_metadata) {
+        // Park the request until metadata_received_alert instead of failing it;
+        // nothing blocks, other requests keep being served meanwhile
+        auto parked = std::make_shared<ParkedRequest>();
+        parked->request = streamRequest;
+        parked->handle = handle;
+        parked->responder = std::make_shared<QHttpServerResponder>(std::move(responder));
+        m_parkedRequests.append(parked);
+        
+        std::weak_ptr<ParkedRequest> weak = parked;
+        QTimer::singleShot(kMetadataWaitMs, this, [this, weak]() {
+            auto expired = weak.lock();
+            if (!expired || !m_parkedRequests.removeOne(expired)) {
+                return;
+            }
+            expired->responder->sendResponse(QHttpServerResponse("text/plain",
+                "Torrent metadata not available yet",
+                QHttpServerResponse::StatusCode::ServiceUnavailable));
+        });
+        return;
+    }
     
-    if (!status.has_metadata) {
-        return QHttpServerResponse("text/plain", "Torrent metadata not available yet", 
-            QHttpServerResponse::StatusCode::ServiceUnavailable);
+    serveStream(streamRequest, handle, responder);
+}
+
+void TorrentStreamServer::resumeParkedRequests(const libtorrent::torrent_handle& handle)
+{
+    QList<std::shared_ptr<ParkedRequest>> ready;
+    for (auto it = m_parkedRequests.begin(); it != m_parkedRequests.end();) {
+        if ((*it)->handle == handle) {
+            ready.append(*it);
+            it = m_parkedRequests.erase(it);
+        } else {
+            ++it;
+        }
     }
     
-    // Get file index (use provided or auto-detect video file)
-    int actualFileIndex = fileIndex;
+    for (const auto& parked : std::as_const(ready)) {
+        serveStream(parked->request, parked->handle, *parked->responder);
+    }
+}
+
+void TorrentStreamServer::failParkedRequests(const libtorrent::torrent_handle& handle)
+{
+    // An invalid handle fails every parked request (server shutdown)
+    for (auto it = m_parkedRequests.begin(); it != m_parkedRequests.end();) {
+        if (!handle.is_valid() || (*it)->handle == handle) {
+            (*it)->responder->sendResponse(QHttpServerResponse(
+                QHttpServerResponse::StatusCode::ServiceUnavailable));
+            it = m_parkedRequests.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void TorrentStreamServer::closeConnection(const QHostAddress& peerAddress, quint16 peerPort)
+{
+    // QHttpServer does not hand out a request's socket; the peer identifies it
+    if (!m_server) {
+        return;
+    }
+    const QList<QTcpSocket*> sockets = m_server->findChildren<QTcpSocket*>();
+    for (QTcpSocket* socket : sockets) {
+        if (socket->peerPort() == peerPort && socket->peerAddress() == peerAddress) {
+            socket->disconnectFromHost();
+            return;
+        }
+    }
+}
+
+void TorrentStreamServer::serveStream(const StreamRequest& streamRequest,
+                                      const libtorrent::torrent_handle& handle,
+                                      QHttpServerResponder& responder)
+{
     auto ti_ptr = handle.torrent_file();
     if (!ti_ptr) {
-        return QHttpServerResponse(QHttpServerResponse::StatusCode::NotFound);
+        responder.sendResponse(QHttpServerResponse(QHttpServerResponse::StatusCode::NotFound));
+        return;
     }
     const libtorrent::torrent_info& ti = *ti_ptr;
     
-    if (actualFileIndex < 0) {
-        // Auto-detect largest video file
-        qint64 maxSize = 0;
-        for (int i = 0; i < ti.num_files(); ++i) {
-            const libtorrent::file_storage& files = ti.files();
-            libtorrent::file_index_t fileIdx(i);
-            QString path = QString::fromStdString(files.file_path(fileIdx));
-            qint64 fileSize = files.file_size(fileIdx);
-            if (path.endsWith(".mp4") || path.endsWith(".mkv") || path.endsWith(".avi") ||
-                path.endsWith(".mov") || path.endsWith(".webm")) {
-                if (fileSize > maxSize) {
-                    maxSize = fileSize;
-                    actualFileIndex = i;
-                }
-            }
-        }
-        
-        if (actualFileIndex < 0) {
-            actualFileIndex = 0; // Fallback to first file
-        }
-    }
+    // Get file index (use provided or auto-detect video file)
+    int actualFileIndex = selectStreamFile(ti, streamRequest.fileIndex);
     
     // Check if file exists in torrent
     if (actualFileIndex >= ti.num_files()) {
-        return QHttpServerResponse(QHttpServerResponse::StatusCode::NotFound);
+        responder.sendResponse(QHttpServerResponse(QHttpServerResponse::StatusCode::NotFound));
+        return;
     }
     
     // Convert to libtorrent::file_index_t for libtorrent API calls
     libtorrent::file_index_t ltFileIndex(actualFileIndex);
+    const libtorrent::file_storage& files = ti.files();
+    qint64 fileSize = files.file_size(ltFileIndex);
     
-    // Handle range requests for video streaming
-    QString rangeHeader = request.value("Range");
-    qint64 start = 0;
-    qint64 end = -1;
+    qint64 start = streamRequest.start;
+    qint64 end = streamRequest.end < 0 ? fileSize - 1 : qMin(streamRequest.end, fileSize - 1);
+    if (streamRequest.suffixLength >= 0) {
+        // A suffix longer than the file covers all of it; "bytes=-0" is unsatisfiable
+        start = streamRequest.suffixLength > 0 ? qMax<qint64>(0, fileSize - streamRequest.suffixLength) : fileSize;
+        end = fileSize - 1;
+    }
     
-    if (!rangeHeader.isEmpty()) {
-        QRegularExpression rangeRegex("bytes=(\\d+)-(\\d*)");
-        QRegularExpressionMatch rangeMatch = rangeRegex.match(rangeHeader);
-        if (rangeMatch.hasMatch()) {
-            start = rangeMatch.captured(1).toLongLong();
-            QString endStr = rangeMatch.captured(2);
-            if (!endStr.isEmpty()) {
-                end = endStr.toLongLong();
+    // Only a range starting past the end is unsatisfiable (invalid specs were dropped)
+    if (start >= fileSize) {
+        responder.sendResponse(QHttpServerResponse(
+            QHttpServerResponse::StatusCode::RequestedRangeNotSatisfiable));
+        return;
+    }
+    
+    QString fileName = QString::fromStdString(files.file_path(ltFileIndex));
+    QMimeDatabase mimeDb;
+    QByteArray mimeType = mimeDb.mimeTypeForFile(fileName, QMimeDatabase::MatchExtension).name().toUtf8();
+    
+    // One read-ahead scheduler per streamed file; every connection gets its own cursor
+    TorrentInfo* info = findTorrentByHandle(handle);
+    if (!info) {
+        responder.sendResponse(QHttpServerResponse(QHttpServerResponse::StatusCode::NotFound));
+        return;
+    }
+    std::shared_ptr<TorrentStreamScheduler> scheduler = ensureScheduler(*info, ti, actualFileIndex);
+    
+    // Stream every piece the range covers; bytes go out as each piece is read,
+    // straight from the downloaded file where the piece is already on disk
+    QString filePath = QDir(info->savePath).filePath(fileName);
+    auto* stream = new TorrentPieceStream(handle, scheduler, ltFileIndex, start, end,
+                                          kStreamWindowBytes, filePath);
+    m_streams.append(stream);
+    ++info->openStreams;
+    ++info->fileReaders[actualFileIndex];
+    updateStatusSubscription(*info);
+    connect(stream, &QObject::destroyed, this, [this, stream, handle, actualFileIndex]() {
+        m_streams.removeAll(stream);
+        if (TorrentInfo* owner = findTorrentByHandle(handle)) {
+            --owner->openStreams;
+            releaseFileReader(*owner, actualFileIndex);
+            updateStatusSubscription(*owner);
+            if (owner->openStreams == 0) {
+                // Player closed the connection (stop, source change or long pause)
+                owner->idleSince.start();
+                requestResumeData(handle);
             }
         }
-    }
+    });
+    // Content-Length has been promised, so a failed stream would leave the player
+    // waiting for the rest of the body: close the connection so it errors out
+    QHostAddress peerAddress = streamRequest.peerAddress;
+    quint16 peerPort = streamRequest.peerPort;
+    connect(stream, &TorrentPieceStream::streamFailed, this, [this, stream, peerAddress, peerPort]() {
+        stream->deleteLater();
+        QTimer::singleShot(0, this, [this, peerAddress, peerPort]() {
+            closeConnection(peerAddress, peerPort);
+        });
+    });
+    QElapsedTimer requestTimer = streamRequest.timer;
+    connect(stream, &TorrentPieceStream::firstBytesRead, this, [this, requestTimer]() {
+        qint64 elapsedMs = requestTimer.elapsed();
+        m_firstByteLatency.record(elapsedMs);
+        LoggingService::logDebug("TorrentStreamServer",
+            QString("Time to first byte: %1 ms").arg(elapsedMs));
+    });
+    connect(stream, &TorrentPieceStream::stalled, this, [this](qint64 stallMs) {
+        if (stallMs < kStallThresholdMs) {
+            return;
+        }
+        ++m_servingStats.stalls;
+        m_servingStats.stallMs += stallMs;
+        m_servingStats.maxStallMs = qMax(m_servingStats.maxStallMs, stallMs);
+    });
+    connect(stream, &TorrentPieceStream::servingFinished, this, [this](qint64 bytes, qint64 elapsedMs) {
+        ++m_servingStats.streams;
+        m_servingStats.bytes += bytes;
+        m_servingStats.servingMs += elapsedMs;
+    });
+    stream->begin();
     
-    // Get file size
-    const libtorrent::file_storage& files = ti.files();
-    qint64 fileSize = files.file_size(ltFileIndex);
+    QByteArray contentLength = QByteArray::number(stream->contentLength());
+    QByteArray contentRange = QString("bytes %1-%2/%3").arg(start).arg(end).arg(fileSize).toUtf8();
+    QHttpServerResponse::StatusCode statusCode = streamRequest.isRange
+        ? QHttpServerResponse::StatusCode::PartialContent
+        : QHttpServerResponse::StatusCode::Ok;
     
-    if (end < 0) {
-        end = fileSize - 1;
+    #if QT_VERSION >= QT_VERSION_CHECK(6, 8, 0)
+    // Newer API: use QHttpHeaders
+    QHttpHeaders headers;
+    headers.append("Content-Type", mimeType);
+    headers.append("Content-Length", contentLength);
+    headers.append("Accept-Ranges", "bytes");
+    if (streamRequest.isRange) {
+        headers.append("Content-Range", contentRange);
+    }
+    // The responder takes ownership of the stream and drains it as data arrives
+    responder.write(stream, headers, statusCode);
+    #else
+    // Older API: header initializer list
+    if (streamRequest.isRange) {
+        responder.write(stream, {
+            {"Content-Type", mimeType},
+            {"Content-Length", contentLength},
+            {"Accept-Ranges", "bytes"},
+            {"Content-Range", contentRange}
+        }, statusCode);
+    } else {
+        responder.write(stream, {
+            {"Content-Type", mimeType},
+            {"Content-Length", contentLength},
+            {"Accept-Ranges", "bytes"}
+        }, statusCode);
     }
+    #endif
+}
+#endif
+
+void TorrentStreamServer::LatencyHistogram::record(qint64 ms)
+{
+    int bucket = 0;
+    while (bucket < kBucketCount - 1 && ms > kBucketBounds[bucket]) {
+        ++bucket;
+    }
+    ++buckets[bucket];
+    ++count;
+    totalMs += ms;
+    maxMs = qMax(maxMs, ms);
+}
+
+qint64 TorrentStreamServer::LatencyHistogram::percentile(double fraction) const
+{
+    if (count == 0) {
+        return 0;
+    }
+    // Upper bound of the bucket holding the requested rank
+    qint64 rank = static_cast<qint64>(fraction * count + 0.5);
+    qint64 seen = 0;
+    for (int i = 0; i < kBucketCount - 1; ++i) {
+        seen += buckets[i];
+        if (seen >= rank) {
+            return qMin(kBucketBounds[i], maxMs);
+        }
+    }
+    return maxMs;
+}
+
+QVariantMap TorrentStreamServer::LatencyHistogram::toVariantMap() const
+{
+    QVariantMap map;
+    map["count"] = count;
+    map["meanMs"] = count > 0 ? totalMs / count : 0;
+    map["maxMs"] = maxMs;
+    map["p50Ms"] = percentile(0.50);
+    map["p95Ms"] = percentile(0.95);
     
-    qint64 contentLength = end - start + 1;
+    QVariantList bucketList;
+    for (int i = 0; i < kBucketCount; ++i) {
+        QVariantMap bucket;
+        bucket["leMs"] = i < kBucketCount - 1 ? QVariant(kBucketBounds[i]) : QVariant();
+        bucket["count"] = buckets[i];
+        bucketList.append(bucket);
+    }
+    map["buckets"] = bucketList;
+    return map;
+}
+
+void TorrentStreamServer::ServingStats::addTo(QVariantMap& map) const
+{
+    map["streams"] = streams;
+    map["bytesServed"] = bytes;
+    map["sustainedBytesPerSecond"] = servingMs > 0 ? bytes * 1000 / servingMs : 0;
+    map["stalls"] = stalls;
+    map["stallMs"] = stallMs;
+    map["maxStallMs"] = maxStallMs;
+}
+
+QString TorrentStreamServer::generateStreamPath(const QString& torrentId, int fileIndex)
+{
+    if (fileIndex >= 0) {
+        return QString("/stream/%1/%2").arg(torrentId, QString::number(fileIndex));
+    }
+    return QString("/stream/%1").arg(torrentId);
+}
+
+int TorrentStreamServer::selectStreamFile(const libtorrent::torrent_info& ti, int requestedIndex)
+{
+    if (requestedIndex >= 0) {
+        return requestedIndex;
+    }
     
-    // Read file data from torrent
-    // Note: This is a simplified implementation. In production, you'd want
-    // to use libtorrent's piece picker to prioritize pieces for streaming
-    QByteArray data;
+    // Auto-detect largest video file
+    int fileIndex = -1;
+    qint64 maxSize = 0;
+    const libtorrent::file_storage& files = ti.files();
+    for (int i = 0; i < ti.num_files(); ++i) {
+        libtorrent::file_index_t fileIdx(i);
+        QString path = QString::fromStdString(files.file_path(fileIdx));
+        qint64 fileSize = files.file_size(fileIdx);
+        if (path.endsWith(".mp4") || path.endsWith(".mkv") || path.endsWith(".avi") ||
+            path.endsWith(".mov") || path.endsWith(".webm")) {
+            if (fileSize > maxSize) {
+                maxSize = fileSize;
+                fileIndex = i;
+            }
+        }
+    }
     
-    // For now, return a simple response indicating the file
-    // In a full implementation, you'd stream the actual file data
-    QString fileName = QString::fromStdString(files.file_path(ltFileIndex));
-    QMimeDatabase mimeDb;
-    QMimeType mimeType = mimeDb.mimeTypeForFile(fileName);
+    return fileIndex < 0 ? 0 : fileIndex; // Fallback to first file
+}
 
-    // Map file range to pieces
-    libtorrent::peer_request pr = ti.map_file(ltFileIndex, start, contentLength);
-    libtorrent::piece_index_t piece_index = pr.piece;
+std::shared_ptr<TorrentStreamScheduler> TorrentStreamServer::ensureScheduler(
+    TorrentInfo& info, const libtorrent::torrent_info& ti, int fileIndex)
+{
+    if (auto existing = info.fileSchedulers.value(fileIndex)) {
+        return existing;
+    }
     
-    // Prioritize pieces for streaming - set deadline to 0 (highest priority)
-    handle.set_piece_deadline(piece_index, 0, libtorrent::torrent_handle::alert_when_available);
+    libtorrent::file_index_t ltFileIndex(fileIndex);
+    const libtorrent::file_storage& files = ti.files();
+    qint64 fileOffset = files.file_offset(ltFileIndex);
+    qint64 fileSize = files.file_size(ltFileIndex);
     
-    // Wait for the piece to be available
-    int maxWaitIterations = 100; // 10 seconds max wait
-    int iterations = 0;
-    while (!handle.have_piece(piece_index) && iterations < maxWaitIterations) {
-        QThread::msleep(100);
-        iterations++;
-        // Process alerts to ensure read_piece_alert is handled
-        processTorrentAlerts();
+    auto scheduler = std::make_shared<TorrentStreamScheduler>(
+        info.handle, fileOffset, fileOffset + fileSize, m_schedulerSettings);
+    scheduler->setPiecesOnDisk(
+        info.handle.status(libtorrent::torrent_handle::query_pieces).pieces);
+    info.fileSchedulers.insert(fileIndex, scheduler);
+    
+    // The played file is the first one streamed. A file opened next to it (subtitles,
+    // sidecars) streams alongside; once nothing reads the played file any more, the
+    // new file takes over (e.g. the next episode of a season pack)
+    if (info.scheduler && info.fileReaders.value(info.scheduledFileIndex) == 0) {
+        info.fileSchedulers.remove(info.scheduledFileIndex);
+        info.scheduler.reset();
+    }
+    if (!info.scheduler) {
+        info.scheduler = scheduler;
+        info.scheduledFileIndex = fileIndex;
+        if (info.durationMs > 0) {
+            scheduler->setBitrate(fileSize * 1000 / info.durationMs);
+        }
     }
     
-    if (!handle.have_piece(piece_index)) {
-        return QHttpServerResponse("Piece not available yet", 
-            QHttpServerResponse::StatusCode::ServiceUnavailable);
+    updateFilePriorities(info, ti);
+    return scheduler;
+}
+
+void TorrentStreamServer::releaseFileReader(TorrentInfo& info, int fileIndex)
+{
+    if (--info.fileReaders[fileIndex] > 0) {
+        return;
+    }
+    info.fileReaders.remove(fileIndex);
+    if (fileIndex == info.scheduledFileIndex) {
+        return; // the played file keeps downloading
+    }
+    info.fileSchedulers.remove(fileIndex);
+    if (auto ti = info.handle.torrent_file()) {
+        updateFilePriorities(info, *ti);
+    }
+}
+
+void TorrentStreamServer::updateFilePriorities(TorrentInfo& info, const libtorrent::torrent_info& ti)
+{
+    // Only spend bandwidth on the played file and the files readers have open
+    std::vector<libtorrent::download_priority_t> filePriorities(
+        static_cast<size_t>(ti.num_files()), libtorrent::dont_download);
+    for (auto it = info.fileSchedulers.cbegin(); it != info.fileSchedulers.cend(); ++it) {
+        filePriorities[static_cast<size_t>(it.key())] = libtorrent::default_priority;
+    }
+    info.handle.prioritize_files(filePriorities);
+}
+
+void TorrentStreamServer::startStartupPrefetch(TorrentInfo& info)
+{
+    auto ti = info.handle.torrent_file();
+    if (!ti || info.isReady) {
+        return;
     }
     
-    // Read the piece asynchronously
-    handle.read_piece(piece_index);
+    int fileIndex = selectStreamFile(*ti, info.fileIndex);
+    if (fileIndex >= ti->num_files()) {
+        return;
+    }
+    ensureScheduler(info, *ti, fileIndex);
+    updateStatusSubscription(info);
     
-    // Wait for read_piece_alert
-    QByteArray pieceData;
-    bool pieceRead = false;
-    iterations = 0;
-    while (!pieceRead && iterations < maxWaitIterations) {
+    // Pin the container header, first seconds of payload and the file tail;
+    // the torrent is ready as soon as those are on disk
+    libtorrent::torrent_status status = info.handle.status(libtorrent::torrent_handle::query_pieces);
+    if (info.scheduler->prefetchStartup(status.pieces)) {
+        markReady(info);
+    }
+}
+
+void TorrentStreamServer::markReady(TorrentInfo& info)
+{
+    if (info.isReady) {
+        return;
+    }
+    info.isReady = true;
+    LoggingService::logInfo("TorrentStreamServer",
+        QString("Startup pieces available, ready to stream: %1").arg(info.streamUrl));
+    emit torrentReady(info.streamUrl);
+    updateStatusSubscription(info);
+}
+
+bool TorrentStreamServer::requestResumeData(const libtorrent::torrent_handle& handle)
+{
+    if (!handle.is_valid() || !handle.torrent_file() || !handle.need_save_resume_data()) {
+        return false;
+    }
+    // Include the info dict so a resumed torrent never waits for metadata again
+    handle.save_resume_data(libtorrent::torrent_handle::flush_disk_cache
+        | libtorrent::torrent_handle::save_info_dict);
+    return true;
+}
+
+bool TorrentStreamServer::handleResumeAlert(libtorrent::alert* alert)
+{
+    if (auto* rd = libtorrent::alert_cast<libtorrent::save_resume_data_alert>(alert)) {
+        // Resume data is saved with flush_disk_cache, so finished pieces are in the files now
+        TorrentInfo* info = findTorrentByHandle(rd->handle);
+        if (info) {
+            for (const auto& scheduler : std::as_const(info->fileSchedulers)) {
+                scheduler->onCacheFlushed();
+            }
+        }
+        std::vector<char> buffer = libtorrent::write_resume_data_buf(rd->params);
+        QString torrentId = info ? info->torrentId : takePendingResumeId(rd->params);
+        QSaveFile file(resumeFilePath(torrentId));
+        if (!file.open(QIODevice::WriteOnly)
+            || file.write(buffer.data(), static_cast<qint64>(buffer.size())) != static_cast<qint64>(buffer.size())
+            || !file.commit()) {
+            LoggingService::logWarning("TorrentStreamServer",
+                QString("Failed to write resume data for %1: %2").arg(torrentId, file.errorString()));
+        }
+        return true;
+    }
+    if (auto* rf = libtorrent::alert_cast<libtorrent::save_resume_data_failed_alert>(alert)) {
+        if (rf->error != libtorrent::errors::resume_data_not_modified) {
+            LoggingService::logWarning("TorrentStreamServer",
+                QString("Failed to save resume data: %1").arg(QString::fromStdString(rf->error.message())));
+        }
+        return true;
+    }
+    return false;
+}
+
+void TorrentStreamServer::saveAllResumeData()
+{
+    int outstanding = 0;
+    for (const auto& entry : m_torrents) {
+        if (requestResumeData(entry.second.handle)) {
+            ++outstanding;
+        }
+    }
+    
+    // Shutting down: other alerts no longer matter, only wait for the saves
+    QElapsedTimer timer;
+    timer.start();
+    while (outstanding > 0 && timer.elapsed() < kResumeSaveTimeoutMs) {
+        if (!m_session.wait_for_alert(std::chrono::milliseconds(100))) {
+            continue;
+        }
         std::vector<libtorrent::alert*> alerts;
         m_session.pop_alerts(&alerts);
-        
         for (libtorrent::alert* alert : alerts) {
-            if (auto* rpa = libtorrent::alert_cast<libtorrent::read_piece_alert>(alert)) {
-                if (rpa->piece == piece_index) {
-                    if (rpa->error) {
-                        return QHttpServerResponse("Error reading piece", 
-                            QHttpServerResponse::StatusCode::InternalServerError);
-                    }
-                    // Extract data from alert buffer
-                    const char* data = static_cast<const char*>(rpa->buffer.get());
-                    int size = rpa->size;
-                    pieceData = QByteArray(data, size);
-                    pieceRead = true;
-                    break;
-                }
+            if (handleResumeAlert(alert)) {
+                --outstanding;
             }
         }
-        
-        if (!pieceRead) {
-            QThread::msleep(100);
-            iterations++;
+    }
+    if (outstanding > 0) {
+        LoggingService::logWarning("TorrentStreamServer",
+            QString("Timed out waiting for resume data of %1 torrent(s)").arg(outstanding));
+    }
+}
+
+QString TorrentStreamServer::takePendingResumeId(const libtorrent::add_torrent_params& params)
+{
+    // The torrent may be keyed by its v1 or its best hash; the alert carries both
+    std::vector<libtorrent::sha1_hash> hashes{infoHashOf(params)};
+#if LIBTORRENT_VERSION_NUM >= 20000
+    if (params.info_hashes.has_v1()) {
+        hashes.push_back(params.info_hashes.v1);
+    }
+#endif
+    for (const libtorrent::sha1_hash& hash : hashes) {
+        auto it = m_pendingResumeIds.find(hash);
+        if (it != m_pendingResumeIds.end()) {
+            QString torrentId = it->second;
+            m_pendingResumeIds.erase(it);
+            return torrentId;
+        }
+    }
+    return torrentIdFor(infoHashOf(params));
+}
+
+QString TorrentStreamServer::resumeFilePath(const QString& torrentId) const
+{
+    return QDir(m_cacheDirectory).absoluteFilePath(torrentId + ".fastresume");
+}
+
+std::shared_ptr<libtorrent::torrent_info> TorrentStreamServer::loadCachedMetadata(
+    const libtorrent::sha1_hash& hash) const
+{
+    if (m_metadataDirectory.isEmpty()) {
+        return nullptr;
+    }
+    QFile file(QDir(m_metadataDirectory).absoluteFilePath(torrentIdFor(hash) + ".torrent"));
+    if (!file.open(QIODevice::ReadOnly)) {
+        return nullptr;
+    }
+    QByteArray bytes = file.readAll();
+    file.close();
+    
+    libtorrent::error_code ec;
+    auto ti = std::make_shared<libtorrent::torrent_info>(
+        libtorrent::span<char const>(bytes.constData(), bytes.size()), ec, libtorrent::from_span);
+#if LIBTORRENT_VERSION_NUM >= 20000
+    bool matches = !ec && (ti->info_hashes().get_best() == hash
+        || (ti->info_hashes().has_v1() && ti->info_hashes().v1 == hash));
+#else
+    bool matches = !ec && ti->info_hash() == hash;
+#endif
+    if (!matches) {
+        LoggingService::logWarning("TorrentStreamServer",
+            QString("Discarding invalid cached metadata %1").arg(file.fileName()));
+        file.remove();
+        return nullptr;
+    }
+    // The modification time orders the cache by last use
+    if (file.open(QIODevice::ReadWrite)) {
+        file.setFileTime(QDateTime::currentDateTime(), QFileDevice::FileModificationTime);
+    }
+    return ti;
+}
+
+void TorrentStreamServer::storeMetadata(const QString& torrentId, const libtorrent::torrent_info& ti)
+{
+    if (m_metadataDirectory.isEmpty()) {
+        return;
+    }
+    QString path = QDir(m_metadataDirectory).absoluteFilePath(torrentId + ".torrent");
+    if (QFileInfo::exists(path)) {
+        return;
+    }
+    
+#if LIBTORRENT_VERSION_NUM >= 20000
+    libtorrent::span<char const> info = ti.info_section();
+    QByteArray infoSection(info.data(), static_cast<qsizetype>(info.size()));
+#else
+    QByteArray infoSection(ti.metadata().get(), ti.metadata_size());
+#endif
+    // A .torrent with only the info dictionary; trackers come from the magnet
+    QByteArray torrentFile = "d4:info" + infoSection + "e";
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly) || file.write(torrentFile) != torrentFile.size() || !file.commit()) {
+        LoggingService::logWarning("TorrentStreamServer",
+            QString("Failed to cache metadata for %1: %2").arg(torrentId, file.errorString()));
+        return;
+    }
+    trimMetadataCache();
+}
+
+void TorrentStreamServer::trimMetadataCache()
+{
+    // Newest first; everything past the limit was used least recently
+    const QFileInfoList files = QDir(m_metadataDirectory).entryInfoList(
+        QStringList() << "*.torrent", QDir::Files, QDir::Time);
+    for (qsizetype i = kMetadataCacheEntries; i < files.size(); ++i) {
+        QFile::remove(files.at(i).absoluteFilePath());
+    }
+}
+
+void TorrentStreamServer::scanCache()
+{
+    m_cachedTorrents.clear();
+    m_cacheScanned = true;
+    
+    // The cache directory is user-configurable: only directories named after an
+    // info-hash that have our resume data (or are known to us) are ours
+    static const QRegularExpression torrentIdPattern("^(?:[0-9a-f]{40}|[0-9a-f]{64})$");
+    const QFileInfoList dirs = QDir(m_cacheDirectory).entryInfoList(QDir::Dirs | QDir::NoDotAndDotDot);
+    for (const QFileInfo& dirInfo : dirs) {
+        QString torrentId = dirInfo.fileName();
+        bool inSession = m_streamIdIndex.contains(torrentId);
+        if (!torrentIdPattern.match(torrentId).hasMatch()
+            || (!inSession && !m_retiredTorrents.contains(torrentId)
+                && !QFileInfo::exists(resumeFilePath(torrentId)))) {
+            continue;
+        }
+        CachedTorrent entry;
+        QDirIterator it(dirInfo.absoluteFilePath(), QDir::Files | QDir::Hidden, QDirIterator::Subdirectories);
+        while (it.hasNext()) {
+            it.next();
+            entry.bytes += it.fileInfo().size();
         }
+        if (inSession) {
+            // Status updates refine this once the torrent reports progress
+            auto session = m_torrents.find(m_streamIdIndex.value(torrentId));
+            if (session != m_torrents.end()) {
+                session->second.diskBytes = qMax(session->second.diskBytes, entry.bytes);
+            }
+            continue;
+        }
+        // Resume data is rewritten whenever playback stops, so it dates the last watch
+        QFileInfo resumeInfo(resumeFilePath(torrentId));
+        entry.lastAccess = resumeInfo.exists() ? resumeInfo.lastModified() : dirInfo.lastModified();
+        m_cachedTorrents.insert(torrentId, entry);
+    }
+}
+
+void TorrentStreamServer::enforceCacheLimit()
+{
+    if (m_cacheLimitBytes <= 0) {
+        return;
+    }
+    // The disk is walked once per cache directory; afterwards sizes come from
+    // torrent status (in the session) or the last known size (retired)
+    if (!m_cacheScanned) {
+        scanCache();
     }
     
-    if (!pieceRead || pieceData.isEmpty()) {
-        return QHttpServerResponse("Failed to read piece data", 
-            QHttpServerResponse::StatusCode::InternalServerError);
+    qint64 totalBytes = 0;
+    for (const CachedTorrent& entry : std::as_const(m_cachedTorrents)) {
+        totalBytes += entry.bytes;
+    }
+    for (const auto& entry : m_torrents) {
+        totalBytes += entry.second.diskBytes;
+    }
+    if (totalBytes <= m_cacheLimitBytes) {
+        return;
     }
     
-    // Calculate offset within the piece
-    // The peer_request already contains the offset within the piece
-    qint64 offsetInPiece = pr.start;
+    QStringList evictable = m_cachedTorrents.keys();
+    std::sort(evictable.begin(), evictable.end(), [this](const QString& a, const QString& b) {
+        return m_cachedTorrents.value(a).lastAccess < m_cachedTorrents.value(b).lastAccess;
+    });
+    for (const QString& torrentId : std::as_const(evictable)) {
+        if (totalBytes <= m_cacheLimitBytes) {
+            break;
+        }
+        qint64 bytes = m_cachedTorrents.take(torrentId).bytes;
+        QDir(QDir(m_cacheDirectory).absoluteFilePath(torrentId)).removeRecursively();
+        QFile::remove(resumeFilePath(torrentId));
+        m_retiredTorrents.remove(torrentId);
+        totalBytes -= bytes;
+        LoggingService::logInfo("TorrentStreamServer",
+            QString("Evicted torrent %1 from cache (%2 MB)").arg(torrentId).arg(bytes / (1024 * 1024)));
+    }
+    if (totalBytes <= m_cacheLimitBytes) {
+        return;
+    }
     
-    // Extract the requested range from the piece data
-    // Use the minimum of mapped length and contentLength to avoid over-reading
-    int extractLength = qMin(static_cast<int>(pr.length), contentLength);
-    QByteArray body = pieceData.mid(offsetInPiece, extractLength);
+    // Still over the limit: detach paused torrents from the session so the next
+    // pass can evict them, once libtorrent has closed their files
+    QList<libtorrent::sha1_hash> retirable;
+    for (const auto& entry : m_torrents) {
+        if (entry.second.paused && entry.second.openStreams == 0) {
+            retirable.append(entry.first);
+        }
+    }
+    std::sort(retirable.begin(), retirable.end(), [this](const libtorrent::sha1_hash& a,
+                                                         const libtorrent::sha1_hash& b) {
+        return m_torrents.at(a).idleSince.elapsed() > m_torrents.at(b).idleSince.elapsed();
+    });
+    for (const libtorrent::sha1_hash& hash : std::as_const(retirable)) {
+        if (totalBytes <= m_cacheLimitBytes) {
+            break;
+        }
+        totalBytes -= m_torrents.at(hash).diskBytes;
+        retireTorrent(hash);
+    }
+}
+
+void TorrentStreamServer::reapIdleTorrents()
+{
+    QList<libtorrent::sha1_hash> expired;
+    for (auto& entry : m_torrents) {
+        TorrentInfo& info = entry.second;
+        if (info.openStreams > 0) {
+            continue;
+        }
+        qint64 idleMs = info.idleSince.elapsed();
+        if (m_idleRemoveMs > 0 && idleMs >= m_idleRemoveMs) {
+            expired.append(entry.first);
+        } else if (m_idlePauseMs > 0 && idleMs >= m_idlePauseMs && !info.paused
+                   && !(info.scheduler && !info.isReady)) {
+            // Torrents still fetching startup pieces (warmed up for a quick start)
+            // keep going until the removal deadline
+            pauseTorrent(info);
+        }
+    }
+    for (const libtorrent::sha1_hash& hash : std::as_const(expired)) {
+        retireTorrent(hash);
+    }
     
-    // If the range spans multiple pieces, we'd need to read more pieces
-    // For now, we handle single-piece ranges. Multi-piece ranges would require
-    // reading multiple pieces and concatenating them.
-    if (extractLength < contentLength) {
-        // Partial data - this happens when range spans multiple pieces
-        // For now, return what we have. A full implementation would read all pieces.
-        LoggingService::logWarning("TorrentStreamServer", 
-            QString("Range request spans multiple pieces, returning partial data"));
-        // Adjust end to match actual data returned
-        end = start + extractLength - 1;
-        contentLength = extractLength;
+    enforceActiveLimit(nullptr);
+    enforceCacheLimit();
+}
+
+void TorrentStreamServer::enforceActiveLimit(const TorrentInfo* keep)
+{
+    if (m_maxActiveTorrents <= 0) {
+        return;
     }
     
-    #if QT_VERSION >= QT_VERSION_CHECK(6, 8, 0)
-    // Newer API: use QHttpHeaders and setHeaders()
-    QHttpHeaders headers;
-    headers.append("Content-Type", mimeType.name().toUtf8());
-    headers.append("Content-Length", QByteArray::number(contentLength));
-    headers.append("Accept-Ranges", "bytes");
-    headers.append("Content-Range", 
-        QString("bytes %1-%2/%3").arg(start).arg(end).arg(fileSize).toUtf8());
+    int active = 0;
+    QList<TorrentInfo*> idle;
+    for (auto& entry : m_torrents) {
+        TorrentInfo& info = entry.second;
+        if (info.paused) {
+            continue;
+        }
+        ++active;
+        if (info.openStreams == 0 && &info != keep) {
+            idle.append(&info);
+        }
+    }
+    if (active <= m_maxActiveTorrents) {
+        return;
+    }
     
-    QHttpServerResponse response(body, QHttpServerResponse::StatusCode::PartialContent);
-    response.setHeaders(headers);
-    return response;
-    #else
-    // Older API: use setHeader() method
-    QHttpServerResponse response(body, QHttpServerResponse::StatusCode::PartialContent);
-    response.setHeader("Content-Type", mimeType.name().toUtf8());
-    response.setHeader("Content-Length", QByteArray::number(contentLength));
-    response.setHeader("Accept-Ranges", "bytes");
-    response.setHeader("Content-Range", 
-        QString("bytes %1-%2/%3").arg(start).arg(end).arg(fileSize).toUtf8());
-    return response;
-    #endif
+    // Longest idle first; torrents with a reader attached are never paused
+    std::sort(idle.begin(), idle.end(), [](const TorrentInfo* a, const TorrentInfo* b) {
+        return a->idleSince.elapsed() > b->idleSince.elapsed();
+    });
+    for (TorrentInfo* info : std::as_const(idle)) {
+        if (active <= m_maxActiveTorrents) {
+            break;
+        }
+        pauseTorrent(*info);
+        --active;
+    }
 }
+
+void TorrentStreamServer::pauseTorrent(TorrentInfo& info)
+{
+    if (info.paused) {
+        return;
+    }
+    info.paused = true;
+    // A paused auto-managed torrent would be started again by the session queue
+    info.handle.unset_flags(libtorrent::torrent_flags::auto_managed);
+    info.handle.pause();
+    requestResumeData(info.handle);
+    updateStatusSubscription(info);
+    LoggingService::logDebug("TorrentStreamServer",
+        QString("Paused idle torrent %1").arg(info.torrentId));
+}
+
+void TorrentStreamServer::resumeTorrent(TorrentInfo& info)
+{
+    if (!info.paused) {
+        return;
+    }
+    // Stays manually managed, so the session queue cannot hold back a stream
+    info.paused = false;
+    info.handle.resume();
+    updateStatusSubscription(info);
+    LoggingService::logDebug("TorrentStreamServer",
+        QString("Resumed torrent %1").arg(info.torrentId));
+}
+
+void TorrentStreamServer::retireTorrent(const libtorrent::sha1_hash& hash)
+{
+    auto it = m_torrents.find(hash);
+    if (it == m_torrents.end()) {
+        return;
+    }
+    RetiredTorrent retired;
+    retired.magnetLink = it->second.magnetLink;
+    retired.fileIndex = it->second.fileIndex;
+    QString torrentId = it->second.torrentId;
+    eraseTorrent(hash);
+    m_retiredTorrents.insert(torrentId, retired);
+    LoggingService::logInfo("TorrentStreamServer",
+        QString("Removed idle torrent %1 (resume data kept)").arg(torrentId));
+}
+
+void TorrentStreamServer::eraseTorrent(const libtorrent::sha1_hash& hash)
+{
+    auto it = m_torrents.find(hash);
+    if (it == m_torrents.end()) {
+        return;
+    }
+    libtorrent::torrent_handle handle = it->second.handle;
+    // Fail open readers, which also closes their connections
+    for (TorrentPieceStream* stream : std::as_const(m_streams)) {
+        if (stream->handle() == handle) {
+            stream->fail("Torrent removed");
+        }
+    }
+#ifdef HAVE_QHTTPSERVER
+    failParkedRequests(handle);
 #endif
+    if (it->second.statusSubscribed && --m_subscribedTorrents == 0) {
+        m_statusTimer->stop();
+    }
+    // The save is queued ahead of the removal, so its alert still arrives; it is
+    // written under the id the next addMagnetLink looks it up by (the magnet's hash)
+    m_pendingResumeIds[hash] = it->second.torrentId;
+    requestResumeData(handle);
+    // The downloaded pieces stay in the cache, and count against its limit
+    CachedTorrent cached;
+    cached.bytes = handle.is_valid()
+        ? handle.status(libtorrent::status_flags_t{}).total_done
+        : it->second.diskBytes;
+    cached.lastAccess = QDateTime::currentDateTime();
+    m_cachedTorrents.insert(it->second.torrentId, cached);
+    m_session.remove_torrent(handle);
+    for (const QString& url : std::as_const(it->second.streamUrls)) {
+        m_streamUrlIndex.remove(url);
+    }
+    m_streamIdIndex.remove(it->second.torrentId);
+    m_torrents.erase(it);
+}
 
-QString TorrentStreamServer::generateStreamPath(const QString& torrentId, int fileIndex)
+bool TorrentStreamServer::reviveTorrent(const QString& torrentId)
 {
-    if (fileIndex >= 0) {
-        return QString("/stream/%1/%2").arg(torrentId, QString::number(fileIndex));
+    auto it = m_retiredTorrents.constFind(torrentId);
+    if (it == m_retiredTorrents.cend()) {
+        return false;
     }
-    return QString("/stream/%1").arg(torrentId);
+    RetiredTorrent retired = it.value();
+    m_retiredTorrents.erase(it);
+    LoggingService::logInfo("TorrentStreamServer",
+        QString("Reader returned, adding idle torrent %1 back").arg(torrentId));
+    return !addMagnetLink(retired.magnetLink, retired.fileIndex).isEmpty();
+}
+
+bool TorrentStreamServer::profileSettings(const QString& profile, libtorrent::settings_pack& settings,
+                                          int& connectionsPerTorrent)
+{
+    using sp = libtorrent::settings_pack;
+    
+    // Shared by every profile
+    settings.set_int(sp::alert_mask,
+        libtorrent::alert::error_notification |
+        libtorrent::alert::status_notification |
+        libtorrent::alert::piece_progress_notification |
+        libtorrent::alert::torrent_log_notification);
+    settings.set_bool(sp::enable_dht, true);
+    settings.set_bool(sp::enable_lsd, true);
+    settings.set_bool(sp::enable_natpmp, true);
+    settings.set_bool(sp::enable_upnp, true);
+    settings.set_int(sp::download_rate_limit, 0); // Unlimited
+    
+    if (profile == "streaming") {
+        // Deadline-driven playback: deep request pipelines, many peers for the
+        // one torrent being watched, and upload capped so it never starves
+        // the download side of the link
+        settings.set_int(sp::upload_rate_limit, 1024 * 1024);
+        settings.set_int(sp::active_downloads, 4);
+        settings.set_int(sp::active_seeds, 2);
+        settings.set_int(sp::connections_limit, 400);
+        settings.set_int(sp::connection_speed, 50);
+        settings.set_int(sp::request_queue_time, 5);
+        settings.set_int(sp::max_out_request_queue, 1500);
+        settings.set_int(sp::max_allowed_in_request_queue, 2000);
+        settings.set_int(sp::piece_timeout, 10);
+        settings.set_int(sp::whole_pieces_threshold, 5);
+        settings.set_bool(sp::prioritize_partial_pieces, true);
+        settings.set_bool(sp::strict_end_game_mode, false);
+        settings.set_int(sp::suggest_mode, sp::suggest_read_cache);
+        connectionsPerTorrent = 200;
+        return true;
+    }
+    if (profile == "balanced") {
+        // The original general-purpose session
+        settings.set_int(sp::upload_rate_limit, 0); // Unlimited
+        settings.set_int(sp::active_downloads, 10);
+        settings.set_int(sp::active_seeds, 10);
+        settings.set_int(sp::connections_limit, 200);
+        settings.set_int(sp::connection_speed, 30);
+        settings.set_int(sp::request_queue_time, 3);
+        settings.set_int(sp::max_out_request_queue, 500);
+        settings.set_int(sp::max_allowed_in_request_queue, 500);
+        settings.set_int(sp::piece_timeout, 20);
+        settings.set_int(sp::whole_pieces_threshold, 20);
+        settings.set_bool(sp::prioritize_partial_pieces, false);
+        settings.set_bool(sp::strict_end_game_mode, true);
+        settings.set_int(sp::suggest_mode, sp::no_piece_suggestions);
+        connectionsPerTorrent = 0xffffff; // libtorrent's "unlimited"
+        return true;
+    }
+    if (profile == "low-resource") {
+        // Weak machines: few sockets, shallow queues, one disk thread
+        settings.set_int(sp::upload_rate_limit, 256 * 1024);
+        settings.set_int(sp::active_downloads, 2);
+        settings.set_int(sp::active_seeds, 0);
+        settings.set_int(sp::connections_limit, 50);
+        settings.set_int(sp::connection_speed, 10);
+        settings.set_int(sp::request_queue_time, 3);
+        settings.set_int(sp::max_out_request_queue, 250);
+        settings.set_int(sp::max_allowed_in_request_queue, 250);
+        settings.set_int(sp::piece_timeout, 20);
+        settings.set_int(sp::whole_pieces_threshold, 20);
+        settings.set_bool(sp::prioritize_partial_pieces, true);
+        settings.set_bool(sp::strict_end_game_mode, true);
+        settings.set_int(sp::suggest_mode, sp::no_piece_suggestions);
+        settings.set_int(sp::aio_threads, 1);
+#if LIBTORRENT_VERSION_NUM < 20000
+        settings.set_int(sp::cache_size, 512); // 16 KiB blocks, 8 MiB
+#endif
+        connectionsPerTorrent = 30;
+        return true;
+    }
+    return false;
+}
+
+libtorrent::sha1_hash TorrentStreamServer::infoHashOf(const libtorrent::add_torrent_params& params)
+{
+#if LIBTORRENT_VERSION_NUM >= 20000
+    return params.info_hashes.get_best();
+#else
+    return params.info_hash;
+#endif
+}
+
+libtorrent::sha1_hash TorrentStreamServer::infoHashOf(const libtorrent::torrent_handle& handle)
+{
+#if LIBTORRENT_VERSION_NUM >= 20000
+    return handle.info_hashes().get_best();
+#else
+    return handle.info_hash();
+#endif
 }
 
-libtorrent::torrent_handle TorrentStreamServer::findTorrentByStreamUrl(const QString& streamUrl) const
+void TorrentStreamServer::updateStatusSubscription(TorrentInfo& info)
 {
-    if (m_torrents.contains(streamUrl)) {
-        return m_torrents.value(streamUrl).handle;
+    // Attached: a reader is open, or startup pieces are still being fetched
+    bool wanted = info.openStreams > 0 || (info.scheduler && !info.isReady && !info.paused);
+    if (wanted == info.statusSubscribed || !info.handle.is_valid()) {
+        return;
     }
-    return libtorrent::torrent_handle();
+    info.statusSubscribed = wanted;
+    if (wanted) {
+        info.handle.set_flags(libtorrent::torrent_flags::update_subscribe);
+        if (m_subscribedTorrents++ == 0) {
+            m_statusTimer->start();
+        }
+    } else {
+        info.handle.unset_flags(libtorrent::torrent_flags::update_subscribe);
+        if (--m_subscribedTorrents == 0) {
+            m_statusTimer->stop();
+        }
+    }
+}
+
+void TorrentStreamServer::postStatusUpdates()
+{
+    // Answered with a state_update_alert covering subscribed torrents that changed
+    m_session.post_torrent_updates(libtorrent::torrent_handle::query_pieces
+        | libtorrent::torrent_handle::query_distributed_copies);
+}
+
+QVariantMap TorrentStreamServer::bufferHealth(const TorrentInfo& info) const
+{
+    qint64 bitrate = info.scheduler ? info.scheduler->bitrate() : m_schedulerSettings.bitrate;
+    QVariantMap health;
+    health["bufferedAheadBytes"] = info.bufferedAheadBytes;
+    health["bufferedAheadSeconds"] = bitrate > 0 ? static_cast<double>(info.bufferedAheadBytes) / bitrate : 0.0;
+    health["windowCompletion"] = info.windowCompletion;
+    health["peers"] = info.peers;
+    health["seeds"] = info.seeds;
+    health["availability"] = info.availability;
+    health["progress"] = info.progress;
+    health["downloadSpeed"] = info.downloadSpeed;
+    health["isReady"] = info.isReady;
+    health["readers"] = info.openStreams;
+    return health;
 }
 
-QString TorrentStreamServer::getTorrentId(const QString& streamUrl) const
+TorrentStreamServer::TorrentInfo* TorrentStreamServer::findTorrentByHandle(const libtorrent::torrent_handle& handle)
 {
-    if (m_torrents.contains(streamUrl)) {
-        libtorrent::sha1_hash hash = m_torrents.value(streamUrl).handle.info_hash();
-        // FIX: Replaced libtorrent::to_hex
-        return QByteArray::fromStdString(hash.to_string()).toHex();
+    if (!handle.is_valid()) {
+        return nullptr;
     }
-    return QString();
+    auto it = m_torrents.find(infoHashOf(handle));
+#if LIBTORRENT_VERSION_NUM >= 20000
+    // A hybrid torrent added by its v1 magnet learns its v2 hash with the metadata
+    if (it == m_torrents.end() && handle.info_hashes().has_v1()) {
+        it = m_torrents.find(handle.info_hashes().v1);
+    }
+#endif
+    return it != m_torrents.end() ? &it->second : nullptr;
+}
+
+TorrentStreamServer::TorrentInfo* TorrentStreamServer::findTorrentByStreamUrl(const QString& streamUrl)
+{
+    auto hashIt = m_streamUrlIndex.constFind(streamUrl);
+    if (hashIt == m_streamUrlIndex.cend()) {
+        return nullptr;
+    }
+    auto it = m_torrents.find(hashIt.value());
+    return it != m_torrents.end() ? &it->second : nullptr;
+}
+
+const TorrentStreamServer::TorrentInfo* TorrentStreamServer::findTorrentByStreamUrl(const QString& streamUrl) const
+{
+    return const_cast<TorrentStreamServer*>(this)->findTorrentByStreamUrl(streamUrl);
+}
+
+QString TorrentStreamServer::torrentIdFor(const libtorrent::sha1_hash& hash)
+{
+    // FIX: Replaced libtorrent::to_hex with Qt's native hex conversion to avoid LNK2019
+    return QString::fromLatin1(QByteArray(hash.data(), static_cast<int>(hash.size())).toHex());
 }
 #endif
\ No newline at end of file
@@ -3,9 +3,16 @@
 
 #include <QObject>
 #include <QString>
-#include <QMap>
+#include <QHash>
+#include <QList>
+#include <QStringList>
 #include <QTimer>
+#include <QElapsedTimer>
+#include <QHostAddress>
+#include <QVariantMap>
+#include <QDateTime>
 #include <memory>
+#include <unordered_map>
 #include <QtQmlIntegration/qqmlintegration.h>
 
 #ifdef TORRENT_SUPPORT_ENABLED
@@ -13,15 +20,20 @@
 #include <QHttpServer>
 #include <QHttpServerRequest>
 #include <QHttpServerResponse>
+#include <QHttpServerResponder>
 #endif
 #include <libtorrent/session.hpp>
 #include <libtorrent/torrent_handle.hpp>
+#include <libtorrent/sha1_hash.hpp>
 #include <libtorrent/read_resume_data.hpp>
 #include <libtorrent/write_resume_data.hpp>
 #include <libtorrent/magnet_uri.hpp>
 #include <libtorrent/torrent_info.hpp>
+#include "torrent_stream_scheduler.h"
 #endif
 
+class TorrentPieceStream;
+
 class TorrentStreamServer : public QObject
 {
     Q_OBJECT
@@ -77,11 +89,81 @@ public:
      */
     Q_INVOKABLE bool isReady(const QString& streamUrl) const;
 
+    /**
+     * @brief Configure the read-ahead window used for newly scheduled streams
+     * @param readAheadSeconds Seconds of playback to keep prioritised ahead of the play head
+     * @param assumedBitrate Bytes per second assumed until the real bitrate is known
+     */
+    void setReadAheadSettings(int readAheadSeconds, qint64 assumedBitrate);
+
+    /**
+     * @brief Tell the scheduler how long the streamed file plays, to derive its bitrate
+     */
+    Q_INVOKABLE void setStreamDuration(const QString& streamUrl, qint64 durationMs);
+
+    /**
+     * @brief Apply a libtorrent session profile to the running session
+     * @param profile "streaming" (default), "balanced" or "low-resource"
+     * @return False if the profile name is unknown
+     */
+    Q_INVOKABLE bool setSessionProfile(const QString& profile);
+    Q_INVOKABLE QString sessionProfile() const;
+
+    /**
+     * @brief Keep downloads and resume data in directory across sessions
+     * @param directory Cache root; each torrent gets a subdirectory named by its info-hash
+     * @param limitBytes Least recently watched torrents are evicted above this size (0 = no limit)
+     */
+    void setCacheSettings(const QString& directory, qint64 limitBytes);
+
+    /**
+     * @brief Keep fetched torrent metadata in directory, keyed by info-hash
+     *
+     * Magnets whose metadata is cached skip the DHT/tracker metadata phase.
+     */
+    void setMetadataCacheDirectory(const QString& directory);
+
+    /**
+     * @brief Configure how torrents without an HTTP reader are torn down
+     * @param pauseAfterSeconds Pause a torrent once no reader was attached for this long (0 = never)
+     * @param removeAfterMinutes Remove a paused torrent from the session after this long,
+     *        keeping its resume data and downloaded pieces (0 = never)
+     * @param maxActiveTorrents Torrents allowed to download at once; the longest idle ones
+     *        are paused beyond this (0 = no limit)
+     */
+    void setIdlePolicy(int pauseAfterSeconds, int removeAfterMinutes, int maxActiveTorrents);
+
+    /**
+     * @brief Save resume data for a stream's torrent, e.g. when playback pauses
+     */
+    Q_INVOKABLE void saveResumeData(const QString& streamUrl);
+
+    /**
+     * @brief Set how often torrent status is polled while a stream is attached
+     */
+    void setStatusInterval(int intervalMs);
+
+    /**
+     * @brief Buffering state of a stream
+     * @return Map with bufferedAheadBytes, bufferedAheadSeconds, windowCompletion,
+     *         peers, seeds, availability, progress, downloadSpeed and isReady
+     */
+    Q_INVOKABLE QVariantMap getBufferHealth(const QString& streamUrl) const;
+
+    /**
+     * @brief Serving statistics over stream requests handled under the current profile
+     * @return Map with profile, the time-to-first-byte histogram (count, meanMs, maxMs,
+     *         p50Ms, p95Ms, buckets of {leMs, count}) and throughput (streams, bytesServed,
+     *         sustainedBytesPerSecond, stalls, stallMs, maxStallMs)
+     */
+    Q_INVOKABLE QVariantMap getFirstByteLatencyStats() const;
+
 signals:
     void torrentAdded(const QString& streamUrl);
     void torrentReady(const QString& streamUrl);
     void torrentError(const QString& streamUrl, const QString& error);
     void progressChanged(const QString& streamUrl, double progress);
+    void bufferHealthChanged(const QString& streamUrl, const QVariantMap& health);
 
 private slots:
     void onTorrentAlert();
@@ -90,27 +172,189 @@ private:
 #ifdef TORRENT_SUPPORT_ENABLED
     struct TorrentInfo {
         libtorrent::torrent_handle handle;
+        QString torrentId;   // hex info-hash used in /stream paths
+        QString streamUrl;   // URL returned by the first addMagnetLink call
+        QStringList streamUrls; // every URL handed out for this torrent
         QString magnetLink;
+        QString savePath;       // directory the torrent's files are downloaded to
         int fileIndex;
         bool isReady;
         double progress;
         qint64 downloadSpeed;
+        // Read-ahead scheduler for the file being played (startup pieces, buffer health)
+        std::shared_ptr<TorrentStreamScheduler> scheduler;
+        int scheduledFileIndex = -1;
+        // Schedulers of the played file and of every file with an open reader
+        QHash<int, std::shared_ptr<TorrentStreamScheduler>> fileSchedulers; // file index -> scheduler
+        QHash<int, int> fileReaders; // file index -> open readers
+        qint64 durationMs = 0;
+        // Status updates are only posted while a stream is attached
+        int openStreams = 0;
+        bool statusSubscribed = false;
+        // Buffer health from the latest state_update_alert
+        int peers = 0;
+        int seeds = 0;
+        double availability = 0.0; // distributed copies of the torrent in the swarm
+        qint64 bufferedAheadBytes = 0;
+        double windowCompletion = 0.0;
+        // Idle teardown: time since the last reader detached (or the torrent was added)
+        QElapsedTimer idleSince;
+        bool paused = false;
+        // Verified bytes on disk (total_done), counted against the cache limit
+        qint64 diskBytes = 0;
+    };
+
+    // Torrent in the download cache but not in the session
+    struct CachedTorrent {
+        qint64 bytes = 0;
+        QDateTime lastAccess;
+    };
+
+    // Torrent removed by the idle reaper; revived when its stream URL is requested again
+    struct RetiredTorrent {
+        QString magnetLink;
+        int fileIndex = -1;
+    };
+
+    // Fixed-bucket latency histogram (milliseconds)
+    struct LatencyHistogram {
+        static constexpr int kBucketCount = 10;
+        static constexpr qint64 kBucketBounds[kBucketCount - 1] = {
+            50, 100, 250, 500, 1000, 2500, 5000, 10000, 30000
+        };
+        qint64 buckets[kBucketCount] = {};
+        qint64 count = 0;
+        qint64 totalMs = 0;
+        qint64 maxMs = 0;
+
+        void record(qint64 ms);
+        qint64 percentile(double fraction) const;
+        QVariantMap toVariantMap() const;
+    };
+
+    // Bytes handed to readers and the time they spent waiting on pieces
+    struct ServingStats {
+        qint64 streams = 0;
+        qint64 bytes = 0;
+        qint64 servingMs = 0;
+        qint64 stalls = 0;
+        qint64 stallMs = 0;
+        qint64 maxStallMs = 0;
+
+        void addTo(QVariantMap& map) const;
+    };
+
+    // Parsed /stream request, independent of the HTTP request object
+    struct StreamRequest {
+        QString torrentId;
+        int fileIndex = -1;
+        bool isRange = false;
+        qint64 start = 0;
+        qint64 end = -1; // -1 = until end of file
+        qint64 suffixLength = -1; // "bytes=-N": the last N bytes, start and end unused
+        QHostAddress peerAddress;
+        quint16 peerPort = 0;
+        QElapsedTimer timer;
     };
 
     void processTorrentAlerts();
 #ifdef HAVE_QHTTPSERVER
-    QHttpServerResponse handleRequest(const QHttpServerRequest& request);
+    // Request waiting for torrent metadata without blocking the event loop
+    struct ParkedRequest {
+        StreamRequest request;
+        libtorrent::torrent_handle handle;
+        std::shared_ptr<QHttpServerResponder> responder;
+    };
+
+    void handleRequest(const QString& torrentId, const QString& fileIndex,
+                       const QHttpServerRequest& request, QHttpServerResponder& responder);
+    void serveStream(const StreamRequest& streamRequest, const libtorrent::torrent_handle& handle,
+                     QHttpServerResponder& responder);
+    void resumeParkedRequests(const libtorrent::torrent_handle& handle);
+    void failParkedRequests(const libtorrent::torrent_handle& handle);
+    void closeConnection(const QHostAddress& peerAddress, quint16 peerPort);
     std::unique_ptr<QHttpServer> m_server;
+    QList<std::shared_ptr<ParkedRequest>> m_parkedRequests;
+    static constexpr int kMetadataWaitMs = 30000;
 #endif
     QString generateStreamPath(const QString& torrentId, int fileIndex);
-    libtorrent::torrent_handle findTorrentByStreamUrl(const QString& streamUrl) const;
-    QString getTorrentId(const QString& streamUrl) const;
+    static QString torrentIdFor(const libtorrent::sha1_hash& hash);
     libtorrent::session m_session;
-    QMap<QString, TorrentInfo> m_torrents; // streamUrl -> TorrentInfo
-    QMap<QString, QString> m_streamUrlToMagnet; // streamUrl -> magnetLink
+    // Torrents keyed by info-hash; node-based, so TorrentInfo pointers stay
+    // valid while other torrents are added or removed
+    std::unordered_map<libtorrent::sha1_hash, TorrentInfo> m_torrents;
+    QHash<QString, libtorrent::sha1_hash> m_streamUrlIndex; // streamUrl -> info-hash
+    QHash<QString, libtorrent::sha1_hash> m_streamIdIndex;  // hex torrent id -> info-hash
+    TorrentInfo* findTorrentByHandle(const libtorrent::torrent_handle& handle);
+    TorrentInfo* findTorrentByStreamUrl(const QString& streamUrl);
+    const TorrentInfo* findTorrentByStreamUrl(const QString& streamUrl) const;
+    static int selectStreamFile(const libtorrent::torrent_info& ti, int requestedIndex);
+    std::shared_ptr<TorrentStreamScheduler> ensureScheduler(TorrentInfo& info,
+                                                            const libtorrent::torrent_info& ti,
+                                                            int fileIndex);
+    void releaseFileReader(TorrentInfo& info, int fileIndex);
+    void updateFilePriorities(TorrentInfo& info, const libtorrent::torrent_info& ti);
+    void startStartupPrefetch(TorrentInfo& info);
+    void markReady(TorrentInfo& info);
+    bool requestResumeData(const libtorrent::torrent_handle& handle);
+    bool handleResumeAlert(libtorrent::alert* alert);
+    void saveAllResumeData();
+    QString resumeFilePath(const QString& torrentId) const;
+    QString takePendingResumeId(const libtorrent::add_torrent_params& params);
+    std::shared_ptr<libtorrent::torrent_info> loadCachedMetadata(const libtorrent::sha1_hash& hash) const;
+    void storeMetadata(const QString& torrentId, const libtorrent::torrent_info& ti);
+    void trimMetadataCache();
+    void scanCache();
+    void enforceCacheLimit();
+    void reapIdleTorrents();
+    void enforceActiveLimit(const TorrentInfo* keep);
+    void pauseTorrent(TorrentInfo& info);
+    void resumeTorrent(TorrentInfo& info);
+    void retireTorrent(const libtorrent::sha1_hash& hash);
+    void eraseTorrent(const libtorrent::sha1_hash& hash);
+    bool reviveTorrent(const QString& torrentId);
+    // Best hash: truncated v2 for v2 and hybrid torrents, v1 otherwise (1.2: v1)
+    static libtorrent::sha1_hash infoHashOf(const libtorrent::add_torrent_params& params);
+    static libtorrent::sha1_hash infoHashOf(const libtorrent::torrent_handle& handle);
+    static bool profileSettings(const QString& profile, libtorrent::settings_pack& settings,
+                                int& connectionsPerTorrent);
+    void updateStatusSubscription(TorrentInfo& info);
+    void postStatusUpdates();
+    QVariantMap bufferHealth(const TorrentInfo& info) const;
+    QList<TorrentPieceStream*> m_streams; // open HTTP response bodies
+    TorrentStreamScheduler::Settings m_schedulerSettings;
+    // Upper bound on piece data requested or buffered ahead of each reader
+    static constexpr qint64 kStreamWindowBytes = 16 * 1024 * 1024;
     quint16 m_port;
     QString m_baseUrl;
     QTimer* m_alertTimer;
+    QTimer* m_statusTimer;
+    QTimer* m_reaperTimer;
+    int m_subscribedTorrents;
+    QString m_cacheDirectory;
+    qint64 m_cacheLimitBytes;
+    // Sizes of cached torrents outside the session: hex torrent id -> entry.
+    // Filled by one disk scan per cache directory, then kept up to date in memory
+    QHash<QString, CachedTorrent> m_cachedTorrents;
+    bool m_cacheScanned;
+    QString m_metadataDirectory;
+    // Most .torrent files kept in the metadata cache; oldest are dropped beyond this
+    static constexpr int kMetadataCacheEntries = 1000;
+    QString m_sessionProfile;
+    int m_connectionsPerTorrent;
+    qint64 m_idlePauseMs;
+    qint64 m_idleRemoveMs;
+    int m_maxActiveTorrents;
+    QHash<QString, RetiredTorrent> m_retiredTorrents; // hex torrent id -> how to add it again
+    // Erased torrents whose resume data is still being saved: info-hash -> torrent id
+    std::unordered_map<libtorrent::sha1_hash, QString> m_pendingResumeIds;
+    static constexpr int kReaperIntervalMs = 5000;
+    // Longest stopServer() waits for outstanding resume data
+    static constexpr int kResumeSaveTimeoutMs = 5000;
+    LatencyHistogram m_firstByteLatency;
+    ServingStats m_servingStats;
+    // Waits shorter than this are scheduling noise rather than stalls
+    static constexpr qint64 kStallThresholdMs = 100;
 #else
     // Stub implementations when libtorrent is not available
     QString m_baseUrl;
@@ -208,6 +208,9 @@ void TraktCoreService::logout()
     m_refreshToken.clear();
     m_tokenExpiry = 0;
     
+    // Cached responses are persisted and belong to this account
+    clearCache();
+    
     if (m_authDao) {
         (void)m_authDao->deleteTraktAuth();
         qDebug() << "[TraktCoreService] User logged out successfully";
@@ -238,77 +241,34 @@ void TraktCoreService::apiRequest(const QString& endpoint, const QString& method
                                   const QJsonObject& data, QObject* receiver, const char* slot)
 {
     // Check cache for GET requests
+    bool revalidate = false;
     if (method == "GET") {
         QString cacheKey = getCacheKey(endpoint);
-        QJsonObject cached = CacheService::getJsonCache(cacheKey);
+        bool fromDisk = false;
+        QVariant cached = CacheService::getCache(cacheKey, &fromDisk);
         
-        if (!cached.isEmpty()) {
+        // Responses are cached already converted (QVariantList / QVariantMap);
+        // anything else is a stale entry from an older format
+        if (cached.typeId() == QMetaType::QVariantList || cached.typeId() == QMetaType::QVariantMap) {
             // Cache hit - emit cached response asynchronously
             LoggingService::logDebug("TraktCoreService", QString("Cache hit for: %1").arg(cacheKey));
             QTimer::singleShot(0, this, [this, endpoint, cached]() {
-                // Parse cached response based on endpoint (same logic as onApiReplyFinished)
-                QJsonArray arr;
-                if (cached.contains("_array")) {
-                    // Array was cached as object with _array key
-                    arr = cached["_array"].toArray();
-                }
-                
-                if (endpoint.contains("/users/me")) {
-                    emit userProfileFetched(cached);
-                } else if (endpoint.contains("/sync/watched/movies")) {
-                    QVariantList movies;
-                    for (const QJsonValue& val : arr) {
-                        movies.append(val.toObject().toVariantMap());
-                    }
-                    emit watchedMoviesFetched(movies);
-                } else if (endpoint.contains("/sync/watched/shows")) {
-                    QVariantList shows;
-                    for (const QJsonValue& val : arr) {
-                        shows.append(val.toObject().toVariantMap());
-                    }
-                    emit watchedShowsFetched(shows);
-                } else if (endpoint.contains("/sync/watchlist/movies")) {
-                    QVariantList movies;
-                    for (const QJsonValue& val : arr) {
-                        movies.append(val.toObject().toVariantMap());
-                    }
-                    emit watchlistMoviesFetched(movies);
-                } else if (endpoint.contains("/sync/watchlist/shows")) {
-                    QVariantList shows;
-                    for (const QJsonValue& val : arr) {
-                        shows.append(val.toObject().toVariantMap());
-                    }
-                    emit watchlistShowsFetched(shows);
-                } else if (endpoint.contains("/sync/collection/movies")) {
-                    QVariantList movies;
-                    for (const QJsonValue& val : arr) {
-                        movies.append(val.toObject().toVariantMap());
-                    }
-                    emit collectionMoviesFetched(movies);
-                } else if (endpoint.contains("/sync/collection/shows")) {
-                    QVariantList shows;
-                    for (const QJsonValue& val : arr) {
-                        shows.append(val.toObject().toVariantMap());
-                    }
-                    emit collectionShowsFetched(shows);
-                } else if (endpoint.contains("/sync/ratings")) {
-                    QVariantList ratings;
-                    for (const QJsonValue& val : arr) {
-                        ratings.append(val.toObject().toVariantMap());
-                    }
-                    emit ratingsFetched(ratings);
-                } else if (endpoint.contains("/sync/playback")) {
-                    QVariantList progress;
-                    for (const QJsonValue& val : arr) {
-                        progress.append(val.toObject().toVariantMap());
-                    }
-                    emit playbackProgressFetched(progress);
-                }
+                emitCachedResponse(endpoint, cached);
             });
-            return; // Skip network request
+            if (!fromDisk) {
+                return; // Skip network request
+            }
+            // Persisted by an earlier run: fetch a fresh copy behind it
+            revalidate = true;
         }
     }
     
+    sendApiRequest(endpoint, method, data, receiver, slot, revalidate);
+}
+
+void TraktCoreService::sendApiRequest(const QString& endpoint, const QString& method, const QJsonObject& data,
+                                      QObject* receiver, const char* slot, bool revalidate)
+{
     // Rate limiting: ensure minimum interval between API calls
     qint64 now = QDateTime::currentMSecsSinceEpoch();
     qint64 timeSinceLastCall = now - m_lastApiCall;
@@ -321,6 +281,7 @@ void TraktCoreService::apiRequest(const QString& endpoint, const QString& method
         request.data = data;
         request.receiver = receiver;
         request.slot = slot;
+        request.revalidate = revalidate;
         m_requestQueue.enqueue(request);
         
         if (!m_queueTimer->isActive()) {
@@ -334,6 +295,9 @@ void TraktCoreService::apiRequest(const QString& endpoint, const QString& method
     // Ensure we have a valid token
     QString token = getAccessTokenSync();
     if (token.isEmpty()) {
+        if (revalidate) {
+            return; // keep the persisted response
+        }
         LoggingService::report("Not authenticated", "AUTH_ERROR", "TraktCoreService");
         emit error("Not authenticated");
         return;
@@ -363,13 +327,19 @@ void TraktCoreService::apiRequest(const QString& endpoint, const QString& method
     if (reply) {
         reply->setProperty("endpoint", endpoint);
         reply->setProperty("method", method);
+        reply->setProperty("revalidate", revalidate);
         if (receiver && slot) {
             // Use old-style connect for const char* slot names
             connect(reply, SIGNAL(finished()), receiver, slot);
         } else {
             connect(reply, &QNetworkReply::finished, this, &TraktCoreService::onApiReplyFinished);
         }
-        connect(reply, &QNetworkReply::errorOccurred, this, [this, reply, endpoint]() {
+        connect(reply, &QNetworkReply::errorOccurred, this, [this, reply, endpoint, revalidate]() {
+            if (revalidate) {
+                qWarning() << "[TraktCoreService] Refresh of persisted response failed for" << endpoint
+                           << ":" << reply->errorString();
+                return;
+            }
             handleError(reply, endpoint);
         });
     }
@@ -385,7 +355,12 @@ void TraktCoreService::processRequestQueue()
     
     while (!m_requestQueue.isEmpty()) {
         QueuedRequest request = m_requestQueue.dequeue();
-        apiRequest(request.endpoint, request.method, request.data, request.receiver, request.slot);
+        if (request.revalidate) {
+            // The cache would answer with the copy being refreshed
+            sendApiRequest(request.endpoint, request.method, request.data, request.receiver, request.slot, true);
+        } else {
+            apiRequest(request.endpoint, request.method, request.data, request.receiver, request.slot);
+        }
         
         // Wait minimum interval before next request
         if (!m_requestQueue.isEmpty()) {
@@ -949,6 +924,11 @@ void TraktCoreService::onApiReplyFinished()
     QString endpoint = reply->property("endpoint").toString();
     
     if (reply->error() != QNetworkReply::NoError) {
+        if (reply->property("revalidate").toBool()) {
+            // The persisted response was emitted already and stays in the cache
+            reply->deleteLater();
+            return;
+        }
         // Emit sync error for sync endpoints
         if (endpoint.contains("/sync/watched/movies") || endpoint.contains("/sync/history/movies")) {
             QString errorMsg = reply->errorString();
@@ -1009,30 +989,23 @@ void TraktCoreService::onApiReplyFinished()
         return;
     }
     
+    // Converted once; the cache and every branch below share this payload
+    QVariant payload = doc.isArray() ? QVariant(doc.array().toVariantList())
+                                     : QVariant(doc.object().toVariantMap());
+    
     // Cache successful GET responses
     QString method = reply->property("method").toString();
     if (method == "GET" && statusCode == 200) {
         QString cacheKey = getCacheKey(endpoint);
         int ttlSeconds = getTtlForEndpoint(endpoint);
-        if (doc.isObject()) {
-            CacheService::setJsonCache(cacheKey, doc.object(), ttlSeconds);
-        } else if (doc.isArray()) {
-            // Convert array to object for caching
-            QJsonObject cacheObj;
-            cacheObj["_array"] = doc.array();
-            CacheService::setJsonCache(cacheKey, cacheObj, ttlSeconds);
-        }
+        CacheService::setCache(cacheKey, payload, ttlSeconds, true);
     }
     
     // Parse response based on endpoint
     if (endpoint.contains("/users/me")) {
         emit userProfileFetched(doc.object());
     } else if (endpoint.contains("/sync/watched/movies") || endpoint.contains("/sync/history/movies")) {
-        QVariantList movies;
-        QJsonArray arr = doc.array();
-        for (const QJsonValue& val : arr) {
-            movies.append(val.toObject().toVariantMap());
-        }
+        QVariantList movies = payload.toList();
         
         qDebug() << "[TraktCoreService] ===== MOVIES SYNC =====";
         qDebug() << "[TraktCoreService] Received" << movies.size() << "watched movies from API";
@@ -1048,11 +1021,7 @@ void TraktCoreService::onApiReplyFinished()
         emit watchedMoviesFetched(movies);
         emit watchedMoviesSynced(addedCount, 0);
     } else if (endpoint.contains("/sync/watched/shows") || endpoint.contains("/sync/history/episodes")) {
-        QVariantList shows;
-        QJsonArray arr = doc.array();
-        for (const QJsonValue& val : arr) {
-            shows.append(val.toObject().toVariantMap());
-        }
+        QVariantList shows = payload.toList();
         
         qDebug() << "[TraktCoreService] ===== SHOWS SYNC =====";
         qDebug() << "[TraktCoreService] Received" << shows.size() << "watched shows/episodes from API";
@@ -1068,46 +1037,22 @@ void TraktCoreService::onApiReplyFinished()
         emit watchedShowsFetched(shows);
         emit watchedShowsSynced(addedCount, 0);
     } else if (endpoint.contains("/sync/watchlist/movies")) {
-        QVariantList movies;
-        QJsonArray arr = doc.array();
-        for (const QJsonValue& val : arr) {
-            movies.append(val.toObject().toVariantMap());
-        }
+        QVariantList movies = payload.toList();
         emit watchlistMoviesFetched(movies);
     } else if (endpoint.contains("/sync/watchlist/shows")) {
-        QVariantList shows;
-        QJsonArray arr = doc.array();
-        for (const QJsonValue& val : arr) {
-            shows.append(val.toObject().toVariantMap());
-        }
+        QVariantList shows = payload.toList();
         emit watchlistShowsFetched(shows);
     } else if (endpoint.contains("/sync/collection/movies")) {
-        QVariantList movies;
-        QJsonArray arr = doc.array();
-        for (const QJsonValue& val : arr) {
-            movies.append(val.toObject().toVariantMap());
-        }
+        QVariantList movies = payload.toList();
         emit collectionMoviesFetched(movies);
     } else if (endpoint.contains("/sync/collection/shows")) {
-        QVariantList shows;
-        QJsonArray arr = doc.array();
-        for (const QJsonValue& val : arr) {
-            shows.append(val.toObject().toVariantMap());
-        }
+        QVariantList shows = payload.toList();
         emit collectionShowsFetched(shows);
     } else if (endpoint.contains("/sync/ratings")) {
-        QVariantList ratings;
-        QJsonArray arr = doc.array();
-        for (const QJsonValue& val : arr) {
-            ratings.append(val.toObject().toVariantMap());
-        }
+        QVariantList ratings = payload.toList();
         emit ratingsFetched(ratings);
     } else if (endpoint.contains("/sync/playback")) {
-        QVariantList progress;
-        QJsonArray arr = doc.array();
-        for (const QJsonValue& val : arr) {
-            progress.append(val.toObject().toVariantMap());
-        }
+        QVariantList progress = payload.toList();
         emit playbackProgressFetched(progress);
     } else if (endpoint.contains("/search/")) {
         QJsonArray arr = doc.array();
@@ -1127,19 +1072,42 @@ void TraktCoreService::onApiReplyFinished()
     reply->deleteLater();
 }
 
+void TraktCoreService::emitCachedResponse(const QString& endpoint, const QVariant& payload)
+{
+    // Same dispatch as onApiReplyFinished, minus the sync side effects
+    QVariantList items = payload.toList();
+    if (endpoint.contains("/users/me")) {
+        emit userProfileFetched(QJsonObject::fromVariantMap(payload.toMap()));
+    } else if (endpoint.contains("/sync/watched/movies")) {
+        emit watchedMoviesFetched(items);
+    } else if (endpoint.contains("/sync/watched/shows")) {
+        emit watchedShowsFetched(items);
+    } else if (endpoint.contains("/sync/watchlist/movies")) {
+        emit watchlistMoviesFetched(items);
+    } else if (endpoint.contains("/sync/watchlist/shows")) {
+        emit watchlistShowsFetched(items);
+    } else if (endpoint.contains("/sync/collection/movies")) {
+        emit collectionMoviesFetched(items);
+    } else if (endpoint.contains("/sync/collection/shows")) {
+        emit collectionShowsFetched(items);
+    } else if (endpoint.contains("/sync/ratings")) {
+        emit ratingsFetched(items);
+    } else if (endpoint.contains("/sync/playback")) {
+        emit playbackProgressFetched(items);
+    }
+}
+
 void TraktCoreService::clearCache()
 {
     // Clear all trakt cache entries
-    CacheService::instance().clear();
+    CacheService::instance().invalidateNamespace("trakt");
     LoggingService::logInfo("TraktCoreService", "Cache cleared");
 }
 
 void TraktCoreService::clearCacheForEndpoint(const QString& endpoint)
 {
-    // Clear cache entries for specific endpoint
-    // Note: CacheService doesn't support prefix-based clearing yet
-    // For now, we'll clear all cache (can be optimized later with prefix support)
-    CacheService::instance().clear();
+    // Clear cache entries for specific endpoint (and its query variants)
+    CacheService::instance().invalidatePrefix(getCacheKey(endpoint));
     LoggingService::logInfo("TraktCoreService", QString("Cleared cache for endpoint: %1").arg(endpoint));
 }
 
@@ -3,6 +3,7 @@
 
 #include <QObject>
 #include <QString>
+#include <QVariant>
 #include <QJsonObject>
 #include <QDateTime>
 #include <QMap>
@@ -96,10 +97,15 @@ private:
     void refreshAccessToken();
     void saveTokens(const QString& accessToken, const QString& refreshToken, int expiresIn);
     
+    // Rate limiting and the network request behind apiRequest(); a revalidating
+    // GET refreshes a persisted response that was already emitted
+    void sendApiRequest(const QString& endpoint, const QString& method, const QJsonObject& data,
+                        QObject* receiver, const char* slot, bool revalidate);
     QUrl buildUrl(const QString& endpoint);
     void handleError(QNetworkReply* reply, const QString& context);
     QString getContentKeyFromPayload(const QJsonObject& payload);
     bool isRecentlyScrobbled(const QString& contentKey);
+    void emitCachedResponse(const QString& endpoint, const QVariant& payload);
     
     std::unique_ptr<QNetworkAccessManager> m_networkManager;
     QSqlDatabase m_database;
@@ -122,6 +128,7 @@ private:
         QJsonObject data;
         QObject* receiver;
         const char* slot;
+        bool revalidate = false;
     };
     QQueue<QueuedRequest> m_requestQueue;
     std::unique_ptr<QTimer> m_queueTimer;
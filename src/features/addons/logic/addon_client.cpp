@@ -1,13 +1,17 @@
 #include "addon_client.h"
+#include "core/services/addon_health_service.h"
+#include "core/di/service_registry.h"
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QJsonArray>
 #include <QDebug>
 #include <QUrlQuery>
+#include <QElapsedTimer>
 
 AddonClient::AddonClient(const QString& baseUrl, QObject* parent)
     : QObject(parent)
     , m_baseUrl(normalizeBaseUrl(baseUrl))
+    , m_timeoutMs(0)
     , m_networkManager(new QNetworkAccessManager(this))
 {
 }
@@ -62,6 +66,58 @@ QUrl AddonClient::buildUrl(const QString& path)
     return QUrl(urlString);
 }
 
+void AddonClient::abort()
+{
+    // Replies are children of the network manager
+    const QList<QNetworkReply*> replies = m_networkManager->findChildren<QNetworkReply*>();
+    for (QNetworkReply* reply : replies) {
+        disconnect(reply, nullptr, this, nullptr);
+        reply->abort();
+        reply->deleteLater();
+    }
+}
+
+QNetworkRequest AddonClient::makeRequest(const QUrl& url) const
+{
+    QNetworkRequest request(url);
+    request.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
+    request.setRawHeader("Accept", "application/json");
+    if (m_timeoutMs > 0) {
+        request.setTransferTimeout(m_timeoutMs);
+    }
+    return request;
+}
+
+void AddonClient::recordResult(const QString& resource, const QNetworkReply* reply, qint64 elapsedMs,
+                               bool validResponse)
+{
+    if (m_addonId.isEmpty()) {
+        return;
+    }
+    auto health = ServiceRegistry::instance().resolve<AddonHealthService>();
+    if (!health) {
+        return;
+    }
+
+    AddonHealthService::Outcome outcome = AddonHealthService::Outcome::Success;
+    QNetworkReply::NetworkError networkError = reply->error();
+    bool timedOut = networkError == QNetworkReply::TimeoutError
+        || (networkError == QNetworkReply::OperationCanceledError && m_timeoutMs > 0 && elapsedMs >= m_timeoutMs);
+    if (timedOut) {
+        outcome = AddonHealthService::Outcome::Timeout;
+    } else if (networkError == QNetworkReply::OperationCanceledError) {
+        return; // aborted by us, says nothing about the addon
+    } else if (networkError != QNetworkReply::NoError) {
+        // A 404 is the addon answering "nothing here"
+        if (reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt() != 404) {
+            outcome = AddonHealthService::Outcome::Error;
+        }
+    } else if (!validResponse) {
+        outcome = AddonHealthService::Outcome::Error;
+    }
+    health->recordResult(m_addonId, resource, elapsedMs, outcome);
+}
+
 QString AddonClient::extractBaseUrl(const QString& manifestUrl)
 {
     QUrl url(manifestUrl);
@@ -97,9 +153,7 @@ QString AddonClient::extractBaseUrl(const QString& manifestUrl)
 void AddonClient::fetchManifest()
 {
     QUrl url = buildUrl("/manifest.json");
-    QNetworkRequest request(url);
-    request.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
-    request.setRawHeader("Accept", "application/json");
+    QNetworkRequest request = makeRequest(url);
     
     // Create local pointer (not member variable)
     QNetworkReply* reply = m_networkManager->get(request);
@@ -134,17 +188,18 @@ void AddonClient::getCatalog(const QString& type, const QString& id)
     }
     
     QUrl url = buildUrl(path);
-    QNetworkRequest request(url);
-    request.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
-    request.setRawHeader("Accept", "application/json");
+    QNetworkRequest request = makeRequest(url);
     
+    QElapsedTimer timer;
+    timer.start();
     QNetworkReply* reply = m_networkManager->get(request);
 
     // Capture 'type' to send back with the signal
-    connect(reply, &QNetworkReply::finished, this, [this, reply, type]() {
+    connect(reply, &QNetworkReply::finished, this, [this, reply, type, timer]() {
         reply->deleteLater();
 
         if (reply->error() != QNetworkReply::NoError) {
+            recordResult("catalog", reply, timer.elapsed());
             // 404 on a catalog usually just means "empty list", not a critical error
             if (reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt() == 404) {
                 emit catalogFetched(type, QJsonArray());
@@ -155,6 +210,7 @@ void AddonClient::getCatalog(const QString& type, const QString& id)
         }
 
         QJsonDocument doc = QJsonDocument::fromJson(reply->readAll());
+        recordResult("catalog", reply, timer.elapsed(), !doc.isNull() && doc.isObject());
         if (doc.isNull() || !doc.isObject()) {
             // Fallback to empty if JSON is bad
             emit catalogFetched(type, QJsonArray());
@@ -173,16 +229,17 @@ void AddonClient::getMeta(const QString& type, const QString& id)
     QString path = QString("/meta/%1/%2.json").arg(type, id);
     QUrl url = buildUrl(path);
     
-    QNetworkRequest request(url);
-    request.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
-    request.setRawHeader("Accept", "application/json");
+    QNetworkRequest request = makeRequest(url);
     
+    QElapsedTimer timer;
+    timer.start();
     QNetworkReply* reply = m_networkManager->get(request);
 
-    connect(reply, &QNetworkReply::finished, this, [this, reply, type, id]() {
+    connect(reply, &QNetworkReply::finished, this, [this, reply, type, id, timer]() {
         reply->deleteLater();
 
         if (reply->error() != QNetworkReply::NoError) {
+            recordResult("meta", reply, timer.elapsed());
             if (reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt() == 404) {
                 emit error(QString("Metadata not found for %1/%2").arg(type, id));
             } else {
@@ -192,6 +249,7 @@ void AddonClient::getMeta(const QString& type, const QString& id)
         }
 
         QJsonDocument doc = QJsonDocument::fromJson(reply->readAll());
+        recordResult("meta", reply, timer.elapsed(), !doc.isNull() && doc.isObject());
         if (doc.isNull() || !doc.isObject()) {
             emit error("Invalid JSON response for metadata");
             return;
@@ -209,16 +267,17 @@ void AddonClient::getStreams(const QString& type, const QString& id)
     
     qDebug() << "AddonClient: Requesting streams:" << url.toString();
     
-    QNetworkRequest request(url);
-    request.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
-    request.setRawHeader("Accept", "application/json");
+    QNetworkRequest request = makeRequest(url);
     
+    QElapsedTimer timer;
+    timer.start();
     QNetworkReply* reply = m_networkManager->get(request);
 
-    connect(reply, &QNetworkReply::finished, this, [this, reply, type, id]() {
+    connect(reply, &QNetworkReply::finished, this, [this, reply, type, id, timer]() {
         reply->deleteLater();
 
         if (reply->error() != QNetworkReply::NoError) {
+            recordResult("stream", reply, timer.elapsed());
             if (reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt() == 404) {
                 emit streamsFetched(type, id, QJsonArray());
             } else {
@@ -229,6 +288,7 @@ void AddonClient::getStreams(const QString& type, const QString& id)
 
         QByteArray data = reply->readAll();
         QJsonDocument doc = QJsonDocument::fromJson(data);
+        recordResult("stream", reply, timer.elapsed(), !doc.isNull() && doc.isObject());
 
         if (doc.isNull() || !doc.isObject()) {
             qDebug() << "AddonClient: Invalid JSON for streams";
@@ -254,16 +314,17 @@ void AddonClient::search(const QString& type, const QString& catalogId, const QS
     QString path = QString("/catalog/%1/%2/search=%3.json").arg(type, catalogId, query);
     QUrl url = buildUrl(path);
     
-    QNetworkRequest request(url);
-    request.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
-    request.setRawHeader("Accept", "application/json");
+    QNetworkRequest request = makeRequest(url);
     
+    QElapsedTimer timer;
+    timer.start();
     QNetworkReply* reply = m_networkManager->get(request);
     
-    connect(reply, &QNetworkReply::finished, this, [this, reply, type]() {
+    connect(reply, &QNetworkReply::finished, this, [this, reply, type, timer]() {
         reply->deleteLater();
         
         if (reply->error() != QNetworkReply::NoError) {
+            recordResult("search", reply, timer.elapsed());
             if (reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt() == 404) {
                 emit searchResultsFetched(type, QJsonArray());
             } else {
@@ -273,6 +334,7 @@ void AddonClient::search(const QString& type, const QString& catalogId, const QS
         }
         
         QJsonDocument doc = QJsonDocument::fromJson(reply->readAll());
+        recordResult("search", reply, timer.elapsed(), !doc.isNull() && doc.isObject());
         if (doc.isNull() || !doc.isObject()) {
             emit searchResultsFetched(type, QJsonArray());
             return;
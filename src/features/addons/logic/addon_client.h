@@ -35,6 +35,21 @@ public:
     // Search for content
     void search(const QString& type, const QString& catalogId, const QString& query);
     
+    /**
+     * @brief Report request latency and failures to AddonHealthService under this addon id
+     */
+    void setAddonId(const QString& addonId) { m_addonId = addonId; }
+    
+    /**
+     * @brief Abort requests that transfer nothing for this long (0 = no timeout)
+     */
+    void setTimeout(int timeoutMs) { m_timeoutMs = timeoutMs; }
+    
+    /**
+     * @brief Abort all in-flight requests; no signal is emitted and no reply is parsed for them
+     */
+    void abort();
+    
     // Static helper methods
     static QString extractBaseUrl(const QString& manifestUrl);
     static bool validateManifest(const AddonManifest& manifest);
@@ -50,8 +65,12 @@ signals:
 private:
     QString normalizeBaseUrl(const QString& url);
     QUrl buildUrl(const QString& path);
+    QNetworkRequest makeRequest(const QUrl& url) const;
+    void recordResult(const QString& resource, const QNetworkReply* reply, qint64 elapsedMs, bool validResponse = true);
     
     QString m_baseUrl;
+    QString m_addonId;
+    int m_timeoutMs;
     QNetworkAccessManager* m_networkManager;
     
     // REMOVED: QNetworkReply* m_currentReply; 
@@ -17,6 +17,7 @@
 #include "core/di/service_registry.h"
 #include "app_controller.h"
 #include "features/addons/logic/addon_repository.h"
+#include "core/services/addon_health_service.h"
 #include "core/services/media_metadata_service.h"
 #include "core/services/trakt_auth_service.h"
 #include "core/services/trakt_core_service.h"
@@ -27,6 +28,7 @@
 #include "core/services/file_export_service.h"
 #include "core/services/local_library_service.h"
 #include "core/services/stream_service.h"
+#include "core/services/torrent_service.h"
 #include "core/services/omdb_service.h"
 #include "core/services/navigation_service.h"
 #include "core/services/logging_service.h"
@@ -147,6 +149,13 @@ int main(int argc, char *argv[])
     });
     qDebug() << "[MAIN] AddonRepository factory registered";
     
+    qDebug() << "[MAIN] Registering AddonHealthService factory...";
+    registry.registerSingleton<AddonHealthService>([]() {
+        qDebug() << "[MAIN] AddonHealthService factory called";
+        return std::make_shared<AddonHealthService>();
+    });
+    qDebug() << "[MAIN] AddonHealthService factory registered";
+    
     qDebug() << "[MAIN] Registering LocalLibraryService factory...";
     registry.registerSingleton<LocalLibraryService>([]() {
         qDebug() << "[MAIN] LocalLibraryService factory called";
@@ -211,10 +220,16 @@ int main(int argc, char *argv[])
     });
     qDebug() << "[MAIN] MediaMetadataService factory registered";
     
-    // Register StreamService (depends on AddonRepository)
+    // Register TorrentService (shared by StreamService and the video player)
+    registry.registerSingleton<TorrentService>([]() {
+        return std::make_shared<TorrentService>();
+    });
+    
+    // Register StreamService (depends on AddonRepository and TorrentService)
     registry.registerSingleton<StreamService>([&registry]() {
         auto addonRepo = registry.resolve<AddonRepository>();
-        return std::make_shared<StreamService>(addonRepo, nullptr);
+        auto torrentService = registry.resolve<TorrentService>();
+        return std::make_shared<StreamService>(addonRepo, nullptr, torrentService);
     });
     
     // Register LibraryService (depends on multiple services)
@@ -378,6 +393,13 @@ int main(int argc, char *argv[])
         qDebug() << "[MAIN] Configuration registered";
     }
     
+    auto torrentService = registry.resolve<TorrentService>();
+    if (torrentService) {
+        qDebug() << "[MAIN] Registering TorrentService...";
+        qmlRegisterSingletonInstance("Yantrium.Services", 1, 0, "TorrentService", torrentService.get());
+        qDebug() << "[MAIN] TorrentService registered";
+    }
+    
     if (streamService) {
         qDebug() << "[MAIN] Registering StreamService...";
         qmlRegisterSingletonInstance("Yantrium.Services", 1, 0, "StreamService", streamService.get());
@@ -439,16 +461,6 @@ int main(int argc, char *argv[])
         });
     qDebug() << "[MAIN] LoggingService registered";
     
-    // Register CacheService
-    qDebug() << "[MAIN] Registering CacheService...";
-    qmlRegisterSingletonType<CacheService>("Yantrium.Services", 1, 0, "CacheService",
-        [](QQmlEngine *engine, QJSEngine *scriptEngine) -> QObject* {
-            Q_UNUSED(engine)
-            Q_UNUSED(scriptEngine)
-            return new CacheService();
-        });
-    qDebug() << "[MAIN] CacheService registered";
-    
     qDebug() << "[MAIN] All QML types registered";
     qDebug() << "[MAIN] Creating QML engine...";
 
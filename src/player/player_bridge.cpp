@@ -6,6 +6,8 @@
 #include <QDebug>
 #include <iostream>
 #include <mdk/global.h>
+#include "core/services/torrent_service.h"
+#include "core/di/service_registry.h"
 
 // Custom renderer class for MDK video playback
 class PlayerRenderer : public QQuickFramebufferObject::Renderer, protected QOpenGLFunctions
@@ -83,6 +85,8 @@ PlayerBridge::PlayerBridge(QQuickItem *parent)
     : QQuickFramebufferObject(parent)
     , m_player(std::make_unique<MDKPlayer>(this))
     , m_source()
+    , m_isTorrentSource(false)
+    , m_durationReported(false)
     , m_isPlaying(false)
 {
     std::cout << "[PlayerBridge] Constructor called - USING QQuickFramebufferObject" << std::endl;
@@ -127,7 +131,19 @@ PlayerBridge::PlayerBridge(QQuickItem *parent)
     
     // Connect to MDKPlayer position changes
     connect(m_player.get(), &MDKPlayer::positionChanged, this, &PlayerBridge::positionChanged);
+    connect(m_player.get(), &MDKPlayer::positionChanged, this, &PlayerBridge::reportTorrentDuration);
     qDebug() << "[PlayerBridge] Connected to MDKPlayer signals";
+    
+    // Buffering info of the torrent being played, for the overlay
+    if (auto torrentService = ServiceRegistry::instance().resolve<TorrentService>()) {
+        connect(torrentService.get(), &TorrentService::bufferHealthChanged, this,
+                [this](const QString &streamUrl, const QVariantMap &health) {
+            if (m_isTorrentSource && streamUrl == m_mediaUrl) {
+                m_bufferHealth = health;
+                emit bufferHealthChanged();
+            }
+        });
+    }
 }
 
 void PlayerBridge::handleWindowChanged(QQuickWindow *win)
@@ -158,8 +174,18 @@ void PlayerBridge::setSource(const QString &source)
     qDebug() << "[PlayerBridge] setSource called with:" << source;
     if (m_source != source) {
         m_source = source;
-        qDebug() << "[PlayerBridge] Setting media to MDKPlayer";
-        m_player->setMedia(source);
+        m_mediaUrl = resolveMediaUrl(source);
+        m_durationReported = false;
+        if (m_isTorrentSource) {
+            if (auto torrentService = ServiceRegistry::instance().resolve<TorrentService>()) {
+                m_bufferHealth = torrentService->getBufferHealth(m_mediaUrl);
+            }
+        } else {
+            m_bufferHealth.clear();
+        }
+        emit bufferHealthChanged();
+        qDebug() << "[PlayerBridge] Setting media to MDKPlayer:" << m_mediaUrl;
+        m_player->setMedia(m_mediaUrl);
         
         // Set video surface size if we have geometry (with HiDPI scaling)
         qDebug() << "[PlayerBridge] Geometry - width:" << width() << "height:" << height();
@@ -185,6 +211,52 @@ void PlayerBridge::setSource(const QString &source)
     }
 }
 
+QString PlayerBridge::resolveMediaUrl(const QString &source)
+{
+    m_isTorrentSource = false;
+    auto torrentService = ServiceRegistry::instance().resolve<TorrentService>();
+    if (!torrentService || !torrentService->isMagnetLink(source)) {
+        return source;
+    }
+    
+    // Stream lists carry unresolved magnets; the torrent joins the session only now
+    QString streamUrl = torrentService->getStreamUrl(source);
+    if (streamUrl.isEmpty()) {
+        qWarning() << "[PlayerBridge] Could not activate torrent source";
+        return source;
+    }
+    m_isTorrentSource = true;
+    return streamUrl;
+}
+
+void PlayerBridge::reportTorrentDuration()
+{
+    if (!m_isTorrentSource || m_durationReported) {
+        return;
+    }
+    int64_t durationMs = m_player->duration();
+    if (durationMs <= 0) {
+        return;
+    }
+    // Lets the torrent read-ahead window follow the real bitrate
+    auto torrentService = ServiceRegistry::instance().resolve<TorrentService>();
+    if (torrentService) {
+        torrentService->setPlaybackDuration(m_mediaUrl, durationMs);
+    }
+    m_durationReported = true;
+}
+
+void PlayerBridge::saveTorrentProgress()
+{
+    if (!m_isTorrentSource) {
+        return;
+    }
+    auto torrentService = ServiceRegistry::instance().resolve<TorrentService>();
+    if (torrentService) {
+        torrentService->saveResumeData(m_mediaUrl);
+    }
+}
+
 bool PlayerBridge::isPlaying() const
 {
     return m_isPlaying;
@@ -210,12 +282,14 @@ void PlayerBridge::pause()
 {
     qDebug() << "[PlayerBridge] pause() called";
     m_player->pause();
+    saveTorrentProgress();
 }
 
 void PlayerBridge::stop()
 {
     qDebug() << "[PlayerBridge] stop() called";
     m_player->stop();
+    saveTorrentProgress();
 }
 
 void PlayerBridge::seek(int64_t ms)
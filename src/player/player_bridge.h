@@ -4,6 +4,7 @@
 #include <QQuickFramebufferObject>
 #include <QQuickWindow>
 #include <QTimer>
+#include <QVariantMap>
 #include <memory>
 #include <QtQmlIntegration/qqmlintegration.h>
 #include "mdk_player.h"
@@ -18,6 +19,9 @@ class PlayerBridge : public QQuickFramebufferObject
     Q_PROPERTY(bool isPlaying READ isPlaying NOTIFY isPlayingChanged)
     Q_PROPERTY(int64_t duration READ duration NOTIFY durationChanged)
     Q_PROPERTY(int64_t position READ position NOTIFY positionChanged)
+    Q_PROPERTY(bool isTorrentSource READ isTorrentSource NOTIFY sourceChanged)
+    // Latest TorrentService buffer health of the playing torrent (empty otherwise)
+    Q_PROPERTY(QVariantMap bufferHealth READ bufferHealth NOTIFY bufferHealthChanged)
     
 public:
     explicit PlayerBridge(QQuickItem *parent = nullptr);
@@ -30,6 +34,8 @@ public:
     bool isPlaying() const;
     int64_t duration() const;
     int64_t position() const;
+    bool isTorrentSource() const { return m_isTorrentSource; }
+    QVariantMap bufferHealth() const { return m_bufferHealth; }
     
     // Q_INVOKABLE methods
     Q_INVOKABLE void play();
@@ -42,6 +48,7 @@ signals:
     void isPlayingChanged();
     void durationChanged();
     void positionChanged();
+    void bufferHealthChanged();
 
 protected:
     Renderer *createRenderer() const override;
@@ -51,10 +58,18 @@ private slots:
     void handleWindowChanged(QQuickWindow *win);
     
 private:
+    QString resolveMediaUrl(const QString &source);
+    void reportTorrentDuration();
+    void saveTorrentProgress();
+
     std::unique_ptr<MDKPlayer> m_player;
     std::unique_ptr<QTimer> m_updateTimer;
     QString m_source;
+    QString m_mediaUrl;         // what MDK plays; differs from m_source for magnets
+    bool m_isTorrentSource;
+    bool m_durationReported;
     bool m_isPlaying;
+    QVariantMap m_bufferHealth;
 };
 
 #endif // PLAYER_BRIDGE_H